@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    ADSREnvelope.h
+    Created: 17 Oct 2026 4:48:09pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <limits>
+
+//==============================================================================
+/**
+Sample-accurate ADSR envelope built from recursive segments.
+
+Every stage is the same one-multiply-one-add recursion,
+    level = level * multiplier + offset,
+run for a precomputed number of samples:
+    - attack:  linear ramp to 1 (multiplier 1, offset 1 / attack samples)
+    - decay:   exponential approach to the sustain level
+    - sustain: glide to the sustain level with a short one-pole smoother
+               until note off, so moving the sustain control never zippers
+    - release: exponential fall, ending (so the voice can be freed) once
+               it drops below the release floor
+A note held at a sustain level below the release floor can't be heard, so
+its sustain stage ends, like a release, once it has glided down to the
+floor, rather than decaying towards 0 for as long as the key is down.
+The multipliers and lengths are worked out once in Coefficients::compute()
+whenever a parameter changes, so rendering never calls exp or pow.
+
+The stage logic is written against plain references (enterStage) so the
+same code drives this single-voice class and VoiceBank's per-lane arrays.
+*/
+class ADSREnvelope
+{
+public:
+    enum Stage : juce::int32
+    {
+        idle = 0,
+        attack,
+        decay,
+        sustain,
+        release
+    };
+
+    /** Times in seconds, sustain as a linear level from 0 to 1. */
+    struct Parameters
+    {
+        float attack = 0.1f;
+        float decay = 0.1f;
+        float sustain = 0.9f;
+        float release = 0.1f;
+
+        bool operator==(const Parameters& other) const noexcept
+        {
+            return attack == other.attack && decay == other.decay
+                && sustain == other.sustain && release == other.release;
+        }
+
+        bool operator!=(const Parameters& other) const noexcept { return ! operator==(other); }
+    };
+
+    /** Per-stage recursion coefficients for one sample rate. */
+    struct Coefficients
+    {
+        /** How far below the target the exponential stages get before snapping to it. */
+        static constexpr double kTargetRatio = 1.0e-3;
+        /**
+        The release time is how long the release takes to fall this far from
+        full level. By default the release also ends here, but compute() can
+        be given a higher floor to cull release tails sooner.
+        */
+        static constexpr double kReleaseFloor = 1.0e-4; // -80 dB
+        /** Time constant of the glide when the sustain level changes. */
+        static constexpr double kSustainGlideSeconds = 0.02;
+
+        void compute(const Parameters& params, double sampleRate,
+                     float releaseFloor = (float) kReleaseFloor) noexcept
+        {
+            const auto samples = [sampleRate](float seconds)
+            {
+                return juce::jmax(0, juce::roundToInt(seconds * sampleRate));
+            };
+
+            attack_samples = samples(params.attack);
+            attack_step = attack_samples > 0 ? 1.0f / (float) attack_samples : 1.0f;
+
+            sustain_level = juce::jlimit(0.0f, 1.0f, params.sustain);
+
+            decay_samples = samples(params.decay);
+            decay_multiplier = decay_samples > 0
+                ? (float) std::exp(std::log(kTargetRatio) / (double) decay_samples)
+                : 0.0f;
+            decay_offset = sustain_level * (1.0f - decay_multiplier);
+
+            sustain_multiplier = (float) std::exp(-1.0 / (kSustainGlideSeconds * sampleRate));
+            sustain_offset = sustain_level * (1.0f - sustain_multiplier);
+
+            release_samples = samples(params.release);
+            release_multiplier = release_samples > 0
+                ? (float) std::exp(std::log(kReleaseFloor) / (double) release_samples)
+                : 0.0f;
+            release_floor = juce::jlimit(1.0e-7f, 1.0f, releaseFloor);
+            release_length_scale = (float) ((double) release_samples / std::log(kReleaseFloor));
+        }
+
+        int attack_samples = 0;
+        float attack_step = 1.0f;
+        int decay_samples = 0;
+        float decay_multiplier = 0.0f;
+        float decay_offset = 0.0f;
+        float sustain_level = 1.0f;
+        float sustain_multiplier = 1.0f;
+        float sustain_offset = 0.0f;
+        int release_samples = 0;
+        float release_multiplier = 0.0f;
+        float release_floor = (float) kReleaseFloor;
+        float release_length_scale = 0.0f; // samples to fall by a factor r = log(r) * this
+    };
+
+    static constexpr juce::int32 kForever = std::numeric_limits<juce::int32>::max();
+
+    /**
+    Moves an envelope into newStage, starting from its current level, and
+    sets up the recursion for it. Stages that would last zero samples are
+    skipped straight through, so afterwards samplesLeft is always > 0.
+    */
+    static void enterStage(const Coefficients& coeffs, juce::int32 newStage,
+                           juce::int32& stage, float& level,
+                           float& multiplier, float& offset,
+                           juce::int32& samplesLeft) noexcept
+    {
+        stage = newStage;
+
+        if (stage == attack)
+        {
+            const auto remaining = (int) std::ceil((1.0f - level) / coeffs.attack_step);
+
+            if (coeffs.attack_samples > 0 && remaining > 0)
+            {
+                multiplier = 1.0f;
+                offset = coeffs.attack_step;
+                samplesLeft = remaining;
+                return;
+            }
+
+            stage = decay;
+        }
+
+        if (stage == decay)
+        {
+            level = 1.0f;
+
+            if (coeffs.decay_samples > 0)
+            {
+                multiplier = coeffs.decay_multiplier;
+                offset = coeffs.decay_offset;
+                samplesLeft = coeffs.decay_samples;
+                return;
+            }
+
+            stage = sustain;
+        }
+
+        if (stage == sustain)
+        {
+            // No snap: if the sustain level moved during the decay, glide to it
+            multiplier = coeffs.sustain_multiplier;
+            offset = coeffs.sustain_offset;
+
+            if (coeffs.sustain_level >= coeffs.release_floor)
+            {
+                samplesLeft = kForever;
+                return;
+            }
+
+            // Inaudible: run only until the glide reaches the floor, so the
+            // voice finishes at the same sample however the blocks fall
+            if (level > coeffs.release_floor && multiplier > 0.0f && multiplier < 1.0f)
+            {
+                samplesLeft = juce::jmax(1, (int) std::ceil(std::log((coeffs.release_floor - coeffs.sustain_level)
+                                                                     / (level - coeffs.sustain_level))
+                                                            / std::log(multiplier)));
+                return;
+            }
+
+            stage = idle;
+        }
+
+        if (stage == release && coeffs.release_samples > 0 && level > coeffs.release_floor)
+        {
+            // Run only as long as this voice needs to get from its current
+            // level down to the floor
+            multiplier = coeffs.release_multiplier;
+            offset = 0.0f;
+            samplesLeft = juce::jmax(1, (int) std::ceil(std::log(coeffs.release_floor / level)
+                                                        * coeffs.release_length_scale));
+            return;
+        }
+
+        stage = idle;
+        level = 0.0f;
+        multiplier = 0.0f;
+        offset = 0.0f;
+        samplesLeft = kForever;
+    }
+
+    /** Called when the current stage has run out of samples. */
+    static void finishStage(const Coefficients& coeffs,
+                            juce::int32& stage, float& level,
+                            float& multiplier, float& offset,
+                            juce::int32& samplesLeft) noexcept
+    {
+        const auto next = stage == release ? (juce::int32) idle : stage + 1;
+        enterStage(coeffs, next, stage, level, multiplier, offset, samplesLeft);
+    }
+
+    //==========================================================================
+    ADSREnvelope()
+    {
+        coeffs_.compute(params_, sample_rate_);
+        reset();
+    }
+
+    void setSampleRate(double sampleRate) noexcept
+    {
+        sample_rate_ = sampleRate;
+        setParameters(params_);
+    }
+
+    /**
+    Recomputes the coefficients. A sustaining note glides to the new sustain
+    level; other stages pick the new shape up at their next stage change.
+    */
+    void setParameters(const Parameters& params) noexcept
+    {
+        params_ = params;
+        coeffs_.compute(params_, sample_rate_);
+
+        if (stage_ == sustain)
+            enter(sustain);
+    }
+
+    const Parameters& getParameters() const noexcept { return params_; }
+    const Coefficients& getCoefficients() const noexcept { return coeffs_; }
+
+    void setAttack(float seconds) noexcept  { params_.attack = seconds;  setParameters(params_); }
+    void setDecay(float seconds) noexcept   { params_.decay = seconds;   setParameters(params_); }
+    void setSustain(float level) noexcept   { params_.sustain = level;   setParameters(params_); }
+    void setRelease(float seconds) noexcept { params_.release = seconds; setParameters(params_); }
+
+    //==========================================================================
+    void noteOn() noexcept  { enter(attack); }
+    void noteOff() noexcept { if (stage_ != idle) enter(release); }
+
+    void reset() noexcept
+    {
+        level_ = 0.0f;
+        enter(idle);
+    }
+
+    bool isActive() const noexcept { return stage_ != idle; }
+    Stage getStage() const noexcept { return (Stage) stage_; }
+    float getLevel() const noexcept { return level_; }
+
+    /**
+    Writes the next numSamples envelope gains into gains.
+    */
+    void render(float* gains, int numSamples) noexcept
+    {
+        int idx = 0;
+
+        while (idx < numSamples)
+        {
+            const int run = juce::jmin(numSamples - idx, samples_left_);
+            auto level = level_;
+
+            for (int end = idx + run; idx < end; ++idx)
+            {
+                level = level * multiplier_ + offset_;
+                gains[idx] = level;
+            }
+
+            level_ = level;
+
+            if (samples_left_ != kForever && (samples_left_ -= run) == 0)
+                finishStage(coeffs_, stage_, level_, multiplier_, offset_, samples_left_);
+        }
+    }
+
+private:
+    void enter(juce::int32 stage) noexcept
+    {
+        enterStage(coeffs_, stage, stage_, level_, multiplier_, offset_, samples_left_);
+    }
+
+    Parameters params_;
+    Coefficients coeffs_;
+    double sample_rate_ = 48000.0;
+
+    juce::int32 stage_ = idle;
+    float level_ = 0.0f;
+    float multiplier_ = 0.0f;
+    float offset_ = 0.0f;
+    juce::int32 samples_left_ = kForever;
+
+    JUCE_LEAK_DETECTOR (ADSREnvelope)
+};
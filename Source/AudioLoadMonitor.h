@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    AudioLoadMonitor.h
+    Created: 17 Oct 2026 8:03:44pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+/**
+Per-callback timing for the audio thread, handed to the message thread
+through a wait-free ring buffer.
+
+The audio thread brackets its work with beginCallback()/endCallback(); that
+costs two high-resolution clock reads and one FIFO write per callback. Each
+record holds the render time as a fraction of the block's deadline (so a
+load above 1 is a missed deadline), the time since the previous callback in
+the same units (well above 1 means the device skipped or dropped a block),
+the voice count and how many input events were queued for the block. If
+the reader falls behind, records are
+dropped and counted rather than blocking the audio thread.
+*/
+class AudioLoadMonitor
+{
+public:
+    struct Record
+    {
+        float load = 0.0f;     // render time / block duration
+        float interval = 1.0f; // time since the previous callback / block duration
+        juce::int32 voices = 0;
+        juce::int32 queued = 0; // input events waiting when the callback began
+    };
+
+    explicit AudioLoadMonitor(int capacity = 1024)
+        : fifo_(capacity), records_((size_t) capacity)
+    {
+    }
+
+    /** Call before the audio device starts, or from prepareToPlay(). */
+    void prepare(double sampleRate) noexcept
+    {
+        sample_rate_ = sampleRate;
+        last_start_ = 0;
+    }
+
+    //==========================================================================
+    // Audio thread
+
+    juce::int64 beginCallback() const noexcept
+    {
+        return juce::Time::getHighResolutionTicks();
+    }
+
+    void endCallback(juce::int64 start, int numSamples, int activeVoices, int queuedEvents) noexcept
+    {
+        const auto end = juce::Time::getHighResolutionTicks();
+
+        if (numSamples <= 0)
+            return;
+
+        const auto deadline = (double) numSamples / sample_rate_ * ticks_per_second_;
+
+        Record record;
+        record.load = (float) ((double) (end - start) / deadline);
+        record.interval = last_start_ != 0 ? (float) ((double) (start - last_start_) / deadline) : 1.0f;
+        record.voices = activeVoices;
+        record.queued = queuedEvents;
+        last_start_ = start;
+
+        auto scope = fifo_.write(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+        {
+            num_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        scope.forEach([&](int idx) { records_[(size_t) idx] = record; });
+    }
+
+    //==========================================================================
+    // Message thread
+
+    /** Hands every waiting record to the callback, oldest first. */
+    template <typename Callback>
+    void drain(Callback&& callback)
+    {
+        auto scope = fifo_.read(fifo_.getNumReady());
+        scope.forEach([&](int idx) { callback(records_[(size_t) idx]); });
+    }
+
+    /** Records lost because the ring was full. */
+    int getNumDropped() const noexcept { return num_dropped_.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo_;
+    std::vector<Record> records_;
+    std::atomic<int> num_dropped_ { 0 };
+
+    const double ticks_per_second_ = (double) juce::Time::getHighResolutionTicksPerSecond();
+    double sample_rate_ = 48000.0;
+    juce::int64 last_start_ = 0; // audio thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioLoadMonitor)
+};
+
+//==============================================================================
+/**
+A small read-out of an AudioLoadMonitor: current and peak load, deadline
+misses, late callbacks, voice counts, the input queue depth and a histogram
+of callback load, all drained from the monitor a few times a second on the
+message thread. The peak load decays rather than resetting on every
+refresh, so a single slow callback stays readable for a second or so.
+*/
+class AudioLoadOverlay  : public juce::Component,
+                          private juce::Timer
+{
+public:
+    explicit AudioLoadOverlay(AudioLoadMonitor& monitor, juce::AudioDeviceManager* deviceManager = nullptr)
+        : monitor_(monitor), device_manager_(deviceManager)
+    {
+        setInterceptsMouseClicks(false, false);
+        startTimerHz(kRefreshRate);
+    }
+
+    ~AudioLoadOverlay() override
+    {
+        stopTimer();
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds();
+        g.setColour(juce::Colours::black.withAlpha(0.7f));
+        g.fillRect(bounds);
+
+        bounds = bounds.reduced(4);
+        auto text = bounds.removeFromTop(kLineHeight * 3);
+        g.setColour(juce::Colours::white);
+        g.setFont(juce::Font((float) kLineHeight - 2.0f));
+
+        juce::String line1;
+        line1 << "load " << juce::roundToInt(100.0f * last_.load) << "%  peak "
+              << juce::roundToInt(100.0f * peak_load_) << "%";
+        juce::String line2;
+        line2 << "misses " << (int) num_misses_ << "  late " << (int) num_late_;
+        if (device_manager_ != nullptr)
+        {
+            const auto xruns = device_manager_->getXRunCount();
+            if (xruns >= 0)
+                line2 << "  xruns " << xruns;
+        }
+        if (monitor_.getNumDropped() > 0)
+            line2 << "  dropped " << monitor_.getNumDropped();
+        juce::String line3;
+        line3 << "voices " << (int) last_.voices << " (max " << (int) peak_voices_ << ")  queued "
+              << (int) last_.queued << " (max " << (int) peak_queued_ << ")";
+
+        g.drawText(line1, text.removeFromTop(kLineHeight), juce::Justification::centredLeft, true);
+        g.drawText(line2, text.removeFromTop(kLineHeight), juce::Justification::centredLeft, true);
+        g.drawText(line3, text.removeFromTop(kLineHeight), juce::Justification::centredLeft, true);
+
+        // Histogram of load, log-scaled so rare slow callbacks still show
+        juce::uint64 most = 1;
+        for (auto count : histogram_)
+            most = juce::jmax(most, count);
+
+        const auto bar_width = (float) bounds.getWidth() / (float) kNumBins;
+        const auto scale = (float) bounds.getHeight() / std::log((float) most + 1.0f);
+
+        for (int bin = 0; bin < kNumBins; ++bin)
+        {
+            const auto height = std::log((float) histogram_[(size_t) bin] + 1.0f) * scale;
+            const auto load = (float) bin / (float) kBinsPerUnit;
+
+            g.setColour(load >= 1.0f ? juce::Colours::red
+                                     : (load >= 0.7f ? juce::Colours::orange : juce::Colours::limegreen));
+            g.fillRect((float) bounds.getX() + (float) bin * bar_width,
+                       (float) bounds.getBottom() - height,
+                       juce::jmax(1.0f, bar_width - 1.0f), height);
+        }
+    }
+
+private:
+    static constexpr int kRefreshRate = 10; // Hz
+    static constexpr int kLineHeight = 14;  // pixels
+    static constexpr int kBinsPerUnit = 20; // 5% per bin
+    static constexpr int kNumBins = kBinsPerUnit * 3 / 2; // the last bin holds everything >= 145%
+
+    void timerCallback() override
+    {
+        peak_load_ *= kPeakDecay;
+        bool received = false;
+
+        monitor_.drain([this, &received](const AudioLoadMonitor::Record& record)
+        {
+            received = true;
+            last_ = record;
+            peak_load_ = juce::jmax(peak_load_, record.load);
+            peak_voices_ = juce::jmax(peak_voices_, record.voices);
+            peak_queued_ = juce::jmax(peak_queued_, record.queued);
+
+            if (record.load >= 1.0f)
+                ++num_misses_;
+            if (record.interval >= kLateInterval)
+                ++num_late_;
+
+            const auto bin = juce::jlimit(0, kNumBins - 1, (int) (record.load * (float) kBinsPerUnit));
+            ++histogram_[(size_t) bin];
+        });
+
+        if (received)
+            repaint();
+    }
+
+    static constexpr float kLateInterval = 1.5f;
+    static constexpr float kPeakDecay = 0.95f; // per refresh: a peak halves in about 1.4 s
+
+    AudioLoadMonitor& monitor_;
+    juce::AudioDeviceManager* device_manager_;
+
+    AudioLoadMonitor::Record last_;
+    float peak_load_ = 0.0f;
+    juce::int32 peak_voices_ = 0;
+    juce::int32 peak_queued_ = 0;
+    juce::uint64 num_misses_ = 0;
+    juce::uint64 num_late_ = 0;
+    std::array<juce::uint64, kNumBins> histogram_ {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioLoadOverlay)
+};
@@ -0,0 +1,470 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+    Created: 17 Oct 2026 7:22:05pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableSynth.h"
+#include "SynthEngine.h"
+
+#include <iostream>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/**
+Headless throughput benchmarks for each stage of the synth.
+
+    --benchmark [--baseline file] [--save-baseline file] [--tolerance 0.1]
+                [--budget 0.7] [--sample-rate hz] [--seconds s] [--threads n]
+
+Every result is the best of several timed trials, in nanoseconds per output
+sample (per table sample for wavetable builds). Engine results also give
+the cost per voice-sample and how many voices one core could render within
+--budget (a fraction of realtime) at that block size. With --threads the
+engine rows are repeated with that many render workers (named ".../mt"),
+where the voice figure is per audio callback rather than per core.
+
+A baseline file holds one "name ns-per-sample" pair per line. With
+--baseline, any result more than --tolerance slower than its baseline is
+flagged and the exit code is 1, so a build box can fail on a regression.
+*/
+class Benchmarks
+{
+public:
+    struct Settings
+    {
+        double sample_rate = 48000.0;
+        double budget = 0.7;          // fraction of each block's deadline the synth may use
+        double seconds = 0.25;        // measuring time per benchmark
+        double tolerance = 0.1;       // allowed slowdown against the baseline
+        juce::File baseline;
+        juce::File save_baseline;
+        int render_threads = 0;
+    };
+
+    struct Result
+    {
+        juce::String name;
+        double ns_per_sample = 0.0;
+        int voices = 0; // > 0 for whole-engine results
+    };
+
+    static bool isBenchmarkCommand(const juce::StringArray& args)
+    {
+        return args.contains("--benchmark");
+    }
+
+    /** Parses args, runs everything and reports; returns the process exit code. */
+    static int runFromCommandLine(const juce::StringArray& args)
+    {
+        Settings settings;
+        settings.sample_rate = getOption(args, "--sample-rate", settings.sample_rate);
+        settings.budget = getOption(args, "--budget", settings.budget);
+        settings.seconds = getOption(args, "--seconds", settings.seconds);
+        settings.tolerance = getOption(args, "--tolerance", settings.tolerance);
+        settings.baseline = getFileOption(args, "--baseline");
+        settings.save_baseline = getFileOption(args, "--save-baseline");
+        settings.render_threads = (int) getOption(args, "--threads", settings.render_threads);
+
+        const auto results = runAll(settings);
+        const bool regressed = report(results, settings);
+
+        if (settings.save_baseline != juce::File())
+        {
+            juce::String text;
+            for (const auto& result : results)
+                text << result.name << " " << juce::String(result.ns_per_sample, 4) << "\n";
+
+            if (! settings.save_baseline.replaceWithText(text))
+            {
+                std::cerr << "Couldn't write " << settings.save_baseline.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+
+        return regressed ? 1 : 0;
+    }
+
+    static std::vector<Result> runAll(const Settings& settings)
+    {
+        std::vector<Result> results;
+        benchmarkOscillator(settings, results);
+        benchmarkWavetableBuild(settings, results);
+        benchmarkEnvelope(settings, results);
+        benchmarkEngine(settings, 0, results);
+        benchmarkUnison(settings, results);
+        benchmarkExpression(settings, results);
+        benchmarkIdle(settings, results);
+
+        if (settings.render_threads > 0)
+            benchmarkEngine(settings, settings.render_threads, results);
+
+        return results;
+    }
+
+private:
+    static constexpr int kTrials = 5;
+    static constexpr int kBlockSize = 512;
+
+    //==========================================================================
+    /**
+    Calls fn repeatedly for settings.seconds in total and returns the best
+    trial's time per sample, given that one call produces samplesPerCall.
+    */
+    template <typename Function>
+    static double measure(const Settings& settings, int samplesPerCall, Function&& fn)
+    {
+        fn(); // warm caches and branch predictors
+
+        const auto ticks_per_second = (double) juce::Time::getHighResolutionTicksPerSecond();
+        const auto trial_ticks = (juce::int64) (settings.seconds / kTrials * ticks_per_second);
+        auto best = std::numeric_limits<double>::max();
+
+        for (int trial = 0; trial < kTrials; ++trial)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            auto now = start;
+            juce::int64 calls = 0;
+
+            do
+            {
+                fn();
+                ++calls;
+                now = juce::Time::getHighResolutionTicks();
+            }
+            while (now - start < trial_ticks);
+
+            const auto seconds = (double) (now - start) / ticks_per_second;
+            best = juce::jmin(best, seconds * 1.0e9 / ((double) calls * samplesPerCall));
+        }
+
+        return best;
+    }
+
+    //==========================================================================
+    static void benchmarkOscillator(const Settings& settings, std::vector<Result>& results)
+    {
+        std::vector<float> output(kBlockSize);
+
+        WavetableSynth synth;
+        synth.setSustain(1.0f);
+        synth.prepareToPlay(kBlockSize, settings.sample_rate);
+        synth.noteOn(440.0f, 1.0f);
+
+        results.push_back({ "oscillator/getNextSample",
+                            measure(settings, kBlockSize, [&]
+                            {
+                                for (int idx = 0; idx < kBlockSize; ++idx)
+                                    output[(size_t) idx] = synth.getNextSample();
+                            }) });
+
+        results.push_back({ "oscillator/renderNextBlock",
+                            measure(settings, kBlockSize, [&]
+                            {
+                                synth.renderNextBlock(output.data(), kBlockSize);
+                            }) });
+
+        benchmarkInterpolation<Interpolation::truncate>(settings, synth, output, results);
+        benchmarkInterpolation<Interpolation::hermite>(settings, synth, output, results);
+        benchmarkInterpolation<Interpolation::lagrange>(settings, synth, output, results);
+        synth.setInterpolation(Interpolation::linear);
+    }
+
+    /** The per-sample and block paths with one of the other interpolation tiers. */
+    template <Interpolation Quality>
+    static void benchmarkInterpolation(const Settings& settings, WavetableSynth& synth,
+                                       std::vector<float>& output, std::vector<Result>& results)
+    {
+        const juce::String name = getInterpolationName(Quality);
+        synth.setInterpolation(Quality);
+
+        results.push_back({ "oscillator/getNextSample/" + name,
+                            measure(settings, kBlockSize, [&]
+                            {
+                                for (int idx = 0; idx < kBlockSize; ++idx)
+                                    output[(size_t) idx] = synth.getNextSample<Quality>();
+                            }) });
+
+        results.push_back({ "oscillator/renderNextBlock/" + name,
+                            measure(settings, kBlockSize, [&]
+                            {
+                                synth.renderNextBlock(output.data(), kBlockSize);
+                            }) });
+    }
+
+    /** The cost of a cache miss: building every mip level of one table. */
+    static void benchmarkWavetableBuild(const Settings& settings, std::vector<Result>& results)
+    {
+        const std::pair<Waveform, const char*> waveforms[] = { { Waveform::sine,     "sine" },
+                                                               { Waveform::saw,      "saw" },
+                                                               { Waveform::square,   "square" },
+                                                               { Waveform::triangle, "triangle" } };
+
+        for (const auto& waveform : waveforms)
+        {
+            results.push_back({ juce::String("wavetable/build/") + waveform.second,
+                                measure(settings, VoiceBank::kTableSize, [&]
+                                {
+                                    SharedWavetable::Ptr table(new SharedWavetable(waveform.first,
+                                                                                   VoiceBank::kTableSize));
+                                }) });
+        }
+    }
+
+    static void benchmarkEnvelope(const Settings& settings, std::vector<Result>& results)
+    {
+        std::vector<float> gains(kBlockSize);
+
+        ADSREnvelope envelope;
+        envelope.setSampleRate(settings.sample_rate);
+        envelope.noteOn();
+
+        results.push_back({ "envelope/render",
+                            measure(settings, kBlockSize, [&]
+                            {
+                                envelope.render(gains.data(), kBlockSize);
+                            }) });
+    }
+
+    /**
+    The whole audio callback path with every voice held in sustain, across
+    voice counts and block sizes.
+    */
+    static void benchmarkEngine(const Settings& settings, int renderThreads, std::vector<Result>& results)
+    {
+        for (const int voices : { 1, 16, 64, 256 })
+        {
+            for (int block_size = 32; block_size <= 2048; block_size *= 2)
+            {
+                SynthEngine engine;
+                engine.setNumRenderThreads(renderThreads);
+                auto& params = engine.getParameters();
+                params.setAttack(0.0f);
+                params.setSustain(1.0f);
+                params.setMaxVoices(VoiceBank::kMaxVoices);
+                engine.prepareToPlay(block_size, settings.sample_rate);
+
+                juce::AudioBuffer<float> buffer(2, block_size);
+                juce::MidiBuffer events;
+
+                for (int voice = 0; voice < voices; ++voice)
+                    events.addEvent(juce::MidiMessage::noteOn(1 + voice / 96, 24 + voice % 96, 1.0f), 0);
+
+                const juce::AudioSourceChannelInfo info(&buffer, 0, block_size);
+                engine.renderNextBlock(info, events);
+                jassert(engine.getNumActiveVoices() == voices);
+
+                events.clear();
+                const auto ns = measure(settings, block_size, [&]
+                {
+                    engine.renderNextBlock(info, events);
+                });
+
+                results.push_back({ "engine/" + juce::String(voices) + "v/" + juce::String(block_size)
+                                      + (renderThreads > 0 ? "/mt" : ""),
+                                    ns, voices });
+            }
+        }
+    }
+
+    /**
+    Eight held notes with growing unison stacks. ns/voice-sample counts every
+    copy as a voice, so it should stay close to the engine rows above.
+    */
+    static void benchmarkUnison(const Settings& settings, std::vector<Result>& results)
+    {
+        constexpr int kNotes = 8;
+
+        for (const int copies : { 1, 7, 16 })
+        {
+            SynthEngine engine;
+            auto& params = engine.getParameters();
+            params.setAttack(0.0f);
+            params.setSustain(1.0f);
+            params.setMaxVoices(VoiceBank::kMaxVoices);
+            params.setUnison(copies);
+            engine.prepareToPlay(kBlockSize, settings.sample_rate);
+
+            juce::AudioBuffer<float> buffer(2, kBlockSize);
+            juce::MidiBuffer events;
+
+            for (int note = 0; note < kNotes; ++note)
+                events.addEvent(juce::MidiMessage::noteOn(1, 48 + 3 * note, 1.0f), 0);
+
+            const juce::AudioSourceChannelInfo info(&buffer, 0, kBlockSize);
+            engine.renderNextBlock(info, events);
+            jassert(engine.getNumActiveVoices() == kNotes * copies);
+
+            events.clear();
+            results.push_back({ "engine/unison" + juce::String(copies) + "/" + juce::String(kNotes) + "notes",
+                                measure(settings, kBlockSize, [&]
+                                {
+                                    engine.renderNextBlock(info, events);
+                                }),
+                                kNotes * copies });
+        }
+    }
+
+    /**
+    Fifteen MPE notes, one per member channel, each sent a pitch bend,
+    pressure and timbre message every block: what a controller player
+    streaming expression costs on top of the notes themselves.
+    */
+    static void benchmarkExpression(const Settings& settings, std::vector<Result>& results)
+    {
+        constexpr int kNotes = 15;
+
+        SynthEngine engine;
+        auto& params = engine.getParameters();
+        params.setAttack(0.0f);
+        params.setSustain(1.0f);
+        engine.prepareToPlay(kBlockSize, settings.sample_rate);
+
+        juce::AudioBuffer<float> buffer(2, kBlockSize);
+        juce::MidiBuffer events;
+
+        for (int note = 0; note < kNotes; ++note)
+            events.addEvent(juce::MidiMessage::noteOn(2 + note, 48 + 3 * note, 1.0f), 0);
+
+        const juce::AudioSourceChannelInfo info(&buffer, 0, kBlockSize);
+        engine.renderNextBlock(info, events);
+        jassert(engine.getNumActiveVoices() == kNotes);
+
+        int block = 0;
+        results.push_back({ "engine/mpe/" + juce::String(kNotes) + "notes",
+                            measure(settings, kBlockSize, [&]
+                            {
+                                events.clear();
+                                const int value = (block++ * 37) % 128;
+
+                                for (int note = 0; note < kNotes; ++note)
+                                {
+                                    const int offset = note * kBlockSize / kNotes;
+                                    events.addEvent(juce::MidiMessage::pitchWheel(2 + note, value * 128), offset);
+                                    events.addEvent(juce::MidiMessage::channelPressureChange(2 + note, value), offset);
+                                    events.addEvent(juce::MidiMessage::controllerEvent(2 + note, 74, value), offset);
+                                }
+
+                                engine.renderNextBlock(info, events);
+                            }),
+                            kNotes });
+    }
+
+    /**
+    The audio callback with nothing playing, after a note has been released
+    and rung out. This should cost about as much as clearing the buffer.
+    */
+    static void benchmarkIdle(const Settings& settings, std::vector<Result>& results)
+    {
+        SynthEngine engine;
+        engine.getParameters().setRelease(0.0f);
+        engine.prepareToPlay(kBlockSize, settings.sample_rate);
+
+        juce::AudioBuffer<float> buffer(2, kBlockSize);
+        juce::MidiBuffer events;
+        events.addEvent(juce::MidiMessage::noteOn(1, 60, 1.0f), 0);
+        events.addEvent(juce::MidiMessage::noteOff(1, 60), kBlockSize / 2);
+
+        const juce::AudioSourceChannelInfo info(&buffer, 0, kBlockSize);
+        engine.renderNextBlock(info, events);
+        jassert(engine.getNumActiveVoices() == 0);
+
+        events.clear();
+        results.push_back({ "engine/idle",
+                            measure(settings, kBlockSize, [&]
+                            {
+                                engine.renderNextBlock(info, events);
+                            }) });
+    }
+
+    //==========================================================================
+    /** Prints every result; returns true if any regressed against the baseline. */
+    static bool report(const std::vector<Result>& results, const Settings& settings)
+    {
+        const auto baseline = loadBaseline(settings.baseline);
+        bool regressed = false;
+
+        std::cout << "Sample rate " << settings.sample_rate << " Hz, budget "
+                  << juce::roundToInt(settings.budget * 100.0) << "% of realtime" << std::endl;
+
+        for (const auto& result : results)
+        {
+            juce::String line = result.name.paddedRight(' ', 28)
+                              + juce::String(result.ns_per_sample, 2).paddedLeft(' ', 10) + " ns/sample";
+
+            if (result.voices > 0)
+            {
+                const auto ns_per_voice = result.ns_per_sample / result.voices;
+                const auto voices_per_core = settings.budget * 1.0e9 / (settings.sample_rate * ns_per_voice);
+
+                line << juce::String(ns_per_voice, 2).paddedLeft(' ', 10) << " ns/voice-sample"
+                     << juce::String(juce::roundToInt(voices_per_core)).paddedLeft(' ', 8) << " voices/core";
+            }
+
+            const int idx = baseline.names.indexOf(result.name);
+            if (idx >= 0)
+            {
+                const auto change = result.ns_per_sample / baseline.values[(size_t) idx] - 1.0;
+                line << juce::String(change * 100.0, 1).paddedLeft(' ', 8) << "%";
+
+                if (change > settings.tolerance)
+                {
+                    line << "  REGRESSION";
+                    regressed = true;
+                }
+            }
+
+            std::cout << line << std::endl;
+        }
+
+        return regressed;
+    }
+
+    struct Baseline
+    {
+        juce::StringArray names;
+        std::vector<double> values;
+    };
+
+    static Baseline loadBaseline(const juce::File& file)
+    {
+        Baseline baseline;
+
+        if (file == juce::File() || ! file.existsAsFile())
+            return baseline;
+
+        for (const auto& line : juce::StringArray::fromLines(file.loadFileAsString()))
+        {
+            const auto tokens = juce::StringArray::fromTokens(line, false);
+            if (tokens.size() == 2 && tokens[1].getDoubleValue() > 0.0)
+            {
+                baseline.names.add(tokens[0]);
+                baseline.values.push_back(tokens[1].getDoubleValue());
+            }
+        }
+
+        return baseline;
+    }
+
+    static double getOption(const juce::StringArray& args, const juce::String& name, double fallback)
+    {
+        const int idx = args.indexOf(name);
+        return idx >= 0 && idx + 1 < args.size() ? args[idx + 1].getDoubleValue() : fallback;
+    }
+
+    static juce::File getFileOption(const juce::StringArray& args, const juce::String& name)
+    {
+        const int idx = args.indexOf(name);
+        return idx >= 0 && idx + 1 < args.size()
+            ? juce::File::getCurrentWorkingDirectory().getChildFile(args[idx + 1].unquoted())
+            : juce::File();
+    }
+};
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    Interpolation.h
+    Created: 17 Oct 2026 10:12:45pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdLanes.h"
+
+//==============================================================================
+/**
+How a wavetable oscillator reads between table samples, cheapest first.
+
+    truncate  the sample at or before the phase; audible as noise on low notes
+    linear    two samples; the default
+    hermite   four-point cubic Hermite (Catmull-Rom)
+    lagrange  four-point third-order Lagrange; flattest passband, most costly
+
+The four-point tiers read one sample before the phase and two after it,
+which SharedWavetable provides as guard samples around every level.
+*/
+enum class Interpolation
+{
+    truncate,
+    linear,
+    hermite,
+    lagrange
+};
+
+inline const char* getInterpolationName(Interpolation quality) noexcept
+{
+    switch (quality)
+    {
+        case Interpolation::truncate: return "truncate";
+        case Interpolation::hermite:  return "hermite";
+        case Interpolation::lagrange: return "lagrange";
+        default:                      return "linear";
+    }
+}
+
+/** Parses a name from getInterpolationName(); returns false if it isn't one. */
+inline bool parseInterpolation(const juce::String& name, Interpolation& quality) noexcept
+{
+    for (auto candidate : { Interpolation::truncate, Interpolation::linear,
+                            Interpolation::hermite, Interpolation::lagrange })
+    {
+        if (name.equalsIgnoreCase(getInterpolationName(candidate)))
+        {
+            quality = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//==============================================================================
+/**
+One interpolation tier, for any lane width: read() returns the table value
+at index + frac for every lane, where index is the table position (already
+including any level offset) and frac is in [0, 1).
+
+With LanesScalar this is the per-sample oscillator path, so one definition
+serves both the single-voice and the lane-parallel kernels. Like the
+kernels, it is plain inline and relies on the SIMD_KERNEL_* wrappers to be
+flattened into them.
+*/
+template <Interpolation Quality>
+struct Interpolator;
+
+template <>
+struct Interpolator<Interpolation::truncate>
+{
+    template <typename Lanes>
+    static inline typename Lanes::Float read(const float* table, typename Lanes::Int index,
+                                             typename Lanes::Float) noexcept
+    {
+        return Lanes::gather(table, index);
+    }
+};
+
+template <>
+struct Interpolator<Interpolation::linear>
+{
+    template <typename Lanes>
+    static inline typename Lanes::Float read(const float* table, typename Lanes::Int index,
+                                             typename Lanes::Float frac) noexcept
+    {
+        const auto y0 = Lanes::gather(table, index);
+        const auto y1 = Lanes::gather(table + 1, index);
+        return Lanes::fmadd(frac, Lanes::sub(y1, y0), y0);
+    }
+};
+
+template <>
+struct Interpolator<Interpolation::hermite>
+{
+    template <typename Lanes>
+    static inline typename Lanes::Float read(const float* table, typename Lanes::Int index,
+                                             typename Lanes::Float frac) noexcept
+    {
+        const auto ym1 = Lanes::gather(table - 1, index);
+        const auto y0 = Lanes::gather(table, index);
+        const auto y1 = Lanes::gather(table + 1, index);
+        const auto y2 = Lanes::gather(table + 2, index);
+        const auto half = Lanes::set1(0.5f);
+
+        // c1 = (y1 - ym1) / 2
+        // c2 = ym1 - 2.5 y0 + 2 y1 - y2 / 2
+        // c3 = (y2 - ym1) / 2 + 1.5 (y0 - y1)
+        const auto c1 = Lanes::mul(half, Lanes::sub(y1, ym1));
+        const auto c2 = Lanes::sub(Lanes::fmadd(Lanes::set1(2.0f), y1, ym1),
+                                   Lanes::fmadd(Lanes::set1(2.5f), y0, Lanes::mul(half, y2)));
+        const auto c3 = Lanes::fmadd(half, Lanes::sub(y2, ym1), Lanes::mul(Lanes::set1(1.5f), Lanes::sub(y0, y1)));
+
+        return Lanes::fmadd(Lanes::fmadd(Lanes::fmadd(c3, frac, c2), frac, c1), frac, y0);
+    }
+};
+
+template <>
+struct Interpolator<Interpolation::lagrange>
+{
+    template <typename Lanes>
+    static inline typename Lanes::Float read(const float* table, typename Lanes::Int index,
+                                             typename Lanes::Float frac) noexcept
+    {
+        const auto ym1 = Lanes::gather(table - 1, index);
+        const auto y0 = Lanes::gather(table, index);
+        const auto y1 = Lanes::gather(table + 1, index);
+        const auto y2 = Lanes::gather(table + 2, index);
+        const auto half = Lanes::set1(0.5f);
+        const auto sixth = Lanes::set1(1.0f / 6.0f);
+
+        // c1 = y1 - ym1 / 3 - y0 / 2 - y2 / 6
+        // c2 = (ym1 + y1) / 2 - y0
+        // c3 = (y2 - ym1) / 6 + (y0 - y1) / 2
+        const auto c1 = Lanes::sub(y1, Lanes::fmadd(Lanes::set1(1.0f / 3.0f), ym1,
+                                                    Lanes::fmadd(half, y0, Lanes::mul(sixth, y2))));
+        const auto c2 = Lanes::sub(Lanes::mul(half, Lanes::add(ym1, y1)), y0);
+        const auto c3 = Lanes::fmadd(sixth, Lanes::sub(y2, ym1), Lanes::mul(half, Lanes::sub(y0, y1)));
+
+        return Lanes::fmadd(Lanes::fmadd(Lanes::fmadd(c3, frac, c2), frac, c1), frac, y0);
+    }
+};
@@ -8,6 +8,9 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
+#include "Benchmarks.h"
+#include "RenderRegression.h"
 
 //==============================================================================
 class SIGMusicWavetableDemoApplication  : public juce::JUCEApplication
@@ -25,6 +28,29 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // Headless tools: run and exit without ever opening a window
+        const auto args = juce::StringArray::fromTokens(commandLine, true);
+        if (OfflineRenderer::isRenderCommand(args))
+        {
+            setApplicationReturnValue(OfflineRenderer::runFromCommandLine(args));
+            quit();
+            return;
+        }
+
+        if (Benchmarks::isBenchmarkCommand(args))
+        {
+            setApplicationReturnValue(Benchmarks::runFromCommandLine(args));
+            quit();
+            return;
+        }
+
+        if (RenderRegression::isRegressionCommand(args))
+        {
+            setApplicationReturnValue(RenderRegression::runFromCommandLine(args));
+            quit();
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
@@ -5,8 +5,13 @@ MainComponent::MainComponent() : audioSetupComp (audioDeviceManager, 0, 0, 0, 25
                                                  true, // showMidiInputOptions must be true
                                                  true,
                                                  true,
-                                                 false)
+                                                 false),
+                                 load_overlay_ (load_monitor_, &deviceManager)
 {
+    // Spare cores help render dense chords; must be set before audio starts
+    synth_.getEngine().setNumRenderThreads(juce::jlimit(0, kMaxRenderThreads,
+                                                        juce::SystemStats::getNumPhysicalCpus() - 2));
+
     // Some platforms require permissions to open input channels so request that here
     if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
         && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
@@ -25,6 +30,7 @@ MainComponent::MainComponent() : audioSetupComp (audioDeviceManager, 0, 0, 0, 25
 
     addAndMakeVisible(audioSetupComp);
     addAndMakeVisible(&synth_);
+    addAndMakeVisible(load_overlay_);
 
     attack_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
     attack_.setRange(0.0, 5.0);
@@ -42,16 +48,54 @@ MainComponent::MainComponent() : audioSetupComp (audioDeviceManager, 0, 0, 0, 25
     release_.setRange(0.0, 5.0);
     release_.setValue(0.1);
     release_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
+    level_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    level_.setRange(0.0, 1.0);
+    level_.setValue(0.8);
+    level_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
+    position_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    position_.setRange(0.0, 1.0);
+    position_.setValue(0.0);
+    position_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
+    spread_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    spread_.setRange(0.0, 1.0);
+    spread_.setValue(0.0);
+    spread_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
+    unison_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    unison_.setRange(1.0, 16.0, 1.0);
+    unison_.setValue(1.0);
+    unison_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
+    detune_.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    detune_.setRange(0.0, 100.0);
+    detune_.setValue(20.0);
+    detune_.setTextBoxStyle(juce::Slider::TextBoxBelow, true, 50, 10);
 
     addAndMakeVisible(attack_);
     addAndMakeVisible(decay_);
     addAndMakeVisible(sustain_);
     addAndMakeVisible(release_);
+    addAndMakeVisible(level_);
+    addAndMakeVisible(position_);
+    addAndMakeVisible(spread_);
+    addAndMakeVisible(unison_);
+    addAndMakeVisible(detune_);
 
     attack_.addListener(this);
     decay_.addListener(this);
     sustain_.addListener(this);
     release_.addListener(this);
+    level_.addListener(this);
+    position_.addListener(this);
+    spread_.addListener(this);
+    unison_.addListener(this);
+    detune_.addListener(this);
+
+    for (auto* slider : {&attack_, &decay_, &sustain_, &release_, &level_, &position_, &spread_, &unison_, &detune_})
+    {
+        sliderValueChanged(slider);
+    }
+
+    wavetable_button_.onClick = [this] { chooseWavetable(); };
+    addAndMakeVisible(wavetable_button_);
 
     // Make sure you set the size of the component after
     // you add any child components.
@@ -68,12 +112,21 @@ MainComponent::~MainComponent()
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
+    load_monitor_.prepare(sampleRate);
     synth_.prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 
 void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
 {
+    const auto start = load_monitor_.beginCallback();
+    auto& engine = synth_.getEngine();
+
+    // Read before the block drains the queues: how far input has backed up
+    const auto queued = engine.getNumQueuedEvents();
+
     synth_.getNextAudioBlock(bufferToFill);
+
+    load_monitor_.endCallback(start, bufferToFill.numSamples, engine.getNumActiveVoices(), queued);
 }
 
 void MainComponent::releaseResources()
@@ -93,49 +146,62 @@ void MainComponent::resized()
     auto local_bounds = getLocalBounds();
     synth_.setBounds(local_bounds.removeFromBottom(kKeyboardHeight));
     auto slider_bounds = local_bounds.removeFromBottom(kSliderHeight);
-    for (auto* slider : {&attack_, &decay_, &sustain_, &release_})
+    for (auto* slider : {&attack_, &decay_, &sustain_, &release_, &level_, &position_, &spread_, &unison_, &detune_})
     {
         slider->setBounds(slider_bounds.removeFromLeft(kSliderWidth));
     }
+    auto overlay_row = local_bounds.removeFromTop(kOverlayHeight);
+    load_overlay_.setBounds(overlay_row.removeFromRight(kOverlayWidth));
+    wavetable_button_.setBounds(overlay_row.removeFromRight(kButtonWidth).removeFromTop(kButtonHeight));
     audioSetupComp.setBounds(local_bounds);
 }
 
 void MainComponent::sliderValueChanged(juce::Slider* slider)
 {
+    // Message thread: just publish the value, the audio thread picks it up
+    // at the start of its next block.
+    auto& params = synth_.getParameters();
+
     if (slider == &attack_)
-    {
-        /*
-        for (auto* voice : synth_.getVoices())
-        {
-            voice->setAttack(attack_.getValue());
-        }
-         */
-    }
+        params.setAttack((float) attack_.getValue());
     else if (slider == &decay_)
-    {
-        */
-        for (auto* voice : synth_.getVoices())
-        {
-            voice->setDecay(decay_.getValue());
-        }
-        */
-    }
+        params.setDecay((float) decay_.getValue());
     else if (slider == &sustain_)
-    {
-        /*
-        for (auto* voice : synth_.getVoices())
-        {
-            voice->setSustain(sustain_.getValue());
-        }
-         */
-    }
+        params.setSustain((float) sustain_.getValue());
     else if (slider == &release_)
+        params.setRelease((float) release_.getValue());
+    else if (slider == &level_)
+        params.setLevel((float) level_.getValue());
+    else if (slider == &position_)
+        params.setPosition((float) position_.getValue());
+    else if (slider == &spread_)
+        params.setStereoSpread((float) spread_.getValue());
+    else if (slider == &unison_)
+        params.setUnison((int) unison_.getValue());
+    else if (slider == &detune_)
+        params.setUnisonDetune((float) detune_.getValue());
+}
+
+void MainComponent::chooseWavetable()
+{
+    wavetable_chooser_ = std::make_unique<juce::FileChooser>("Load a wavetable", juce::File(), "*.wav");
+
+    wavetable_chooser_->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                    [this](const juce::FileChooser& chooser)
     {
-        /*
-        for (auto* voice : synth_.getVoices())
+        const auto file = chooser.getResult();
+        if (file == juce::File())
+            return;
+
+        // Built on the engine's loader thread; the audio keeps playing the
+        // old table until the new one is ready
+        synth_.getEngine().loadWavetable(file, [](const juce::String& error)
         {
-            voice->setRelease(release_.getValue());
-        }
-         */
-    }
+            juce::MessageManager::callAsync([error]
+            {
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon,
+                                                       "Wavetable", error);
+            });
+        });
+    });
 }
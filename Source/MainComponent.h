@@ -4,6 +4,7 @@
 
 #include "SynthKeyboard.h"
 #include "Scene.h"
+#include "AudioLoadMonitor.h"
 
 //==============================================================================
 /*
@@ -41,15 +42,34 @@ private:
     static const int kWindowWidth = 800;
     static const int kKeyboardHeight = 100; // pixels
     static const int kSliderHeight = 300; // pixels
-    static const int kSliderWidth = kWindowWidth / 4; // pixels
+    static const int kSliderWidth = kWindowWidth / 9; // pixels
+    static const int kOverlayWidth = 280; // pixels
+    static const int kOverlayHeight = 120; // pixels
+    static const int kMaxRenderThreads = 7;
+    static const int kButtonWidth = 120; // pixels
+    static const int kButtonHeight = 24; // pixels
+
+    void chooseWavetable();
+
     SynthKeyboard synth_;
     juce::AudioDeviceManager audioDeviceManager;
     juce::AudioDeviceSelectorComponent audioSetupComp;
 
+    AudioLoadMonitor load_monitor_;
+    AudioLoadOverlay load_overlay_;
+
     juce::Slider attack_;
     juce::Slider decay_;
     juce::Slider sustain_;
     juce::Slider release_;
+    juce::Slider level_;
+    juce::Slider position_; // wavetable frame
+    juce::Slider spread_; // stereo spread
+    juce::Slider unison_; // copies per note
+    juce::Slider detune_; // unison detune, cents
+
+    juce::TextButton wavetable_button_ { "Wavetable..." };
+    std::unique_ptr<juce::FileChooser> wavetable_chooser_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
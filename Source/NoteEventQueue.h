@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    NoteEventQueue.h
+    Created: 17 Oct 2026 10:12:03am
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+//==============================================================================
+/**
+A note event travelling from a GUI/MIDI thread to the audio thread.
+
+time is when the event arrived, in seconds on the
+Time::getMillisecondCounterHiRes() clock; the audio thread uses it to place
+the event at the right sample inside its next block.
+*/
+struct NoteEvent
+{
+    enum class Type : juce::uint8
+    {
+        noteOn,
+        noteOff,
+        sustainOn,
+        sustainOff,
+        controller, // note is the controller number, velocity its value over 127
+        pitchBend,  // velocity is the bend, from -1 to 1
+        pressure    // channel pressure; velocity is its value over 127
+    };
+
+    Type type = Type::noteOn;
+    juce::uint8 channel = 1;
+    juce::uint8 note = 0;
+    float velocity = 0.0f;
+    double time = 0.0;
+
+    /** Seconds on the clock that time is measured against. */
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    juce::MidiMessage toMidiMessage() const noexcept
+    {
+        switch (type)
+        {
+            case Type::noteOn:     return juce::MidiMessage::noteOn(channel, note, velocity);
+            case Type::sustainOn:  return juce::MidiMessage::controllerEvent(channel, 64, 127);
+            case Type::sustainOff: return juce::MidiMessage::controllerEvent(channel, 64, 0);
+            case Type::controller: return juce::MidiMessage::controllerEvent(channel, note, juce::roundToInt(velocity * 127.0f));
+            case Type::pitchBend:  return juce::MidiMessage::pitchWheel(channel, juce::jlimit(0, 16383, juce::roundToInt((velocity + 1.0f) * 8192.0f)));
+            case Type::pressure:   return juce::MidiMessage::channelPressureChange(channel, juce::roundToInt(velocity * 127.0f));
+            case Type::noteOff:
+            default:               return juce::MidiMessage::noteOff(channel, note, velocity);
+        }
+    }
+};
+
+//==============================================================================
+/**
+Wait-free single-producer/single-consumer queue of NoteEvents.
+
+The storage is allocated once in the constructor, so pushing and draining never
+allocate or lock. Exactly one thread may push and exactly one thread (the audio
+thread) may drain; use one queue per producing thread.
+*/
+class NoteEventQueue
+{
+public:
+    explicit NoteEventQueue(int capacity = 1024)
+        : fifo_(capacity), events_((size_t) capacity)
+    {
+    }
+
+    /**
+    Adds an event to the queue. Returns false (and drops the event) if the
+    consumer has fallen so far behind that the queue is full.
+    */
+    bool push(const NoteEvent& event) noexcept
+    {
+        auto scope = fifo_.write(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        scope.forEach([&](int idx) { events_[(size_t) idx] = event; });
+        return true;
+    }
+
+    /**
+    Hands every queued event to the callback, oldest first.
+    */
+    template <typename Callback>
+    void drain(Callback&& callback) noexcept
+    {
+        auto scope = fifo_.read(fifo_.getNumReady());
+        scope.forEach([&](int idx) { callback(events_[(size_t) idx]); });
+    }
+
+    /** How many events are waiting to be drained. */
+    int getNumReady() const noexcept { return fifo_.getNumReady(); }
+
+    /**
+    Discards everything in the queue. Only call this from the consumer thread.
+    */
+    void clear() noexcept
+    {
+        drain([](const NoteEvent&) {});
+    }
+
+private:
+    juce::AbstractFifo fifo_;
+    std::vector<NoteEvent> events_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteEventQueue)
+};
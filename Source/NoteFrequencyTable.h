@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    NoteFrequencyTable.h
+    Created: 17 Oct 2026 9:37:08pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/** Compile-time helpers for NoteFrequencyTable. */
+namespace NoteFrequencyMath
+{
+    constexpr int kFineSteps = 64;
+
+    /** 2^x, accurate to double precision, for building the tables at compile time. */
+    constexpr double exp2(double x)
+    {
+        double scale = 1.0;
+        for (; x >= 1.0; x -= 1.0) scale *= 2.0;
+        for (; x < 0.0; x += 1.0)  scale *= 0.5;
+
+        // e^(x ln 2) by its Taylor series; x is in [0, 1) here
+        const double y = x * 0.69314718055994530942;
+        double term = 1.0, sum = 1.0;
+        for (int n = 1; n < 30; ++n)
+        {
+            term *= y / n;
+            sum += term;
+        }
+
+        return scale * sum;
+    }
+
+    constexpr std::array<double, 128> makeFrequencies()
+    {
+        std::array<double, 128> frequencies {};
+        for (int note = 0; note < 128; ++note)
+            frequencies[(size_t) note] = 440.0 * exp2((note - 69) / 12.0);
+
+        return frequencies;
+    }
+
+    constexpr std::array<double, kFineSteps> makeFineRatios()
+    {
+        std::array<double, kFineSteps> ratios {};
+        for (int step = 0; step < kFineSteps; ++step)
+            ratios[(size_t) step] = exp2(step / (12.0 * kFineSteps));
+
+        return ratios;
+    }
+
+    inline constexpr std::array<double, 128> kFrequencies = makeFrequencies();
+    inline constexpr std::array<double, kFineSteps> kFineRatios = makeFineRatios();
+}
+
+//==============================================================================
+/**
+MIDI note number to frequency and to oscillator phase step, by table lookup.
+
+The frequencies of the 128 notes (A4 = 440 Hz, equal temperament) are
+generated at compile time. prepare() turns them into fixed-point phase steps
+for one sample rate at kStepsPerSemitone steps per semitone, so a note-on
+(or a note bent by a fraction of a semitone) costs one load instead of a
+pow() and a divide. Phase steps use the same scale as the oscillators: the
+full 32-bit range is one cycle.
+*/
+class NoteFrequencyTable
+{
+public:
+    static constexpr int kNumNotes = 128;
+    static constexpr int kStepsPerSemitone = NoteFrequencyMath::kFineSteps; // about 1.6 cents
+    static constexpr int kNumSteps = kNumNotes * kStepsPerSemitone;
+    static constexpr double kPhaseScale = 4294967296.0;
+
+    /** The frequency of a MIDI note, in Hz. Usable in constant expressions. */
+    static constexpr double getFrequency(int note) noexcept
+    {
+        // A plain conditional: jlimit isn't constexpr
+        return NoteFrequencyMath::kFrequencies[(size_t) (note < 0 ? 0 : note > kNumNotes - 1 ? kNumNotes - 1 : note)];
+    }
+
+    NoteFrequencyTable()
+        : increments_((size_t) kNumSteps)
+    {
+        prepare(48000.0);
+    }
+
+    /** Rebuilds the phase steps for a sample rate. Allocates nothing after construction. */
+    void prepare(double sampleRate) noexcept
+    {
+        jassert(sampleRate > 0.0);
+        const auto scale = kPhaseScale / sampleRate;
+
+        for (int step = 0; step < kNumSteps; ++step)
+        {
+            const auto frequency = NoteFrequencyMath::kFrequencies[(size_t) (step / kStepsPerSemitone)]
+                                   * NoteFrequencyMath::kFineRatios[(size_t) (step % kStepsPerSemitone)];
+            increments_[(size_t) step] = (juce::uint32) (juce::int64) std::llround(frequency * scale);
+        }
+    }
+
+    /** The phase step per sample for a MIDI note. */
+    juce::uint32 getIncrement(int note) const noexcept
+    {
+        return increments_[(size_t) (juce::jlimit(0, kNumNotes - 1, note) * kStepsPerSemitone)];
+    }
+
+    /**
+    The phase step per sample for a note bent by semitones (pitch bend or
+    modulation), clamped to the note range. It is interpolated between the
+    two nearest steps, which keeps a slow bend smooth rather than moving in
+    1.6-cent stairs.
+    */
+    juce::uint32 getIncrement(int note, float semitones) const noexcept
+    {
+        const auto position = juce::jlimit(0.0, (double) (kNumSteps - 1),
+                                           (double) note * kStepsPerSemitone + (double) semitones * kStepsPerSemitone);
+        const int step = juce::jmin((int) position, kNumSteps - 2);
+        const auto below = (double) increments_[(size_t) step];
+        const auto above = (double) increments_[(size_t) step + 1];
+
+        return (juce::uint32) (juce::int64) std::llround(below + (position - step) * (above - below));
+    }
+
+private:
+    std::vector<juce::uint32> increments_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteFrequencyTable)
+};
@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 17 Oct 2026 6:40:27pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SynthEngine.h"
+
+#include <iostream>
+
+//==============================================================================
+/**
+Headless bounce of a MIDI file to a WAV file through SynthEngine, with no
+audio device and no window, as fast as the CPU allows.
+
+    --render <input.mid> <output.wav>
+             [--attack s] [--decay s] [--sustain 0-1] [--release s]
+             [--level 0-1] [--sample-rate hz] [--block-size samples]
+             [--tail s] [--threads n]
+             [--interpolation truncate|linear|hermite|lagrange]
+             [--wavetable file.wav] [--frame-size samples] [--position 0-1]
+             [--spread 0-1] [--unison copies] [--detune cents]
+
+Blocks are rendered with the same engine code the audio callback uses; the
+MIDI file's events are placed at their exact sample positions instead of
+going through the realtime queues, so the output is the same on every run.
+*/
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        juce::File input;
+        juce::File output;
+        ADSREnvelope::Parameters envelope;
+        float level = 0.8f;
+        double sample_rate = 48000.0;
+        int block_size = 512;
+        double tail_seconds = 1.0; // rendered after the last event so releases can finish
+        int bit_depth = 24;
+        int render_threads = 0; // extra worker threads for dense passages
+        Interpolation interpolation = Interpolation::linear;
+        juce::File wavetable; // File() for the built-in sine
+        int frame_size = WavetableLoader::kFrameSizeFromFile; // or samples per frame, to split a bank
+        float position = 0.0f; // wavetable frame, 0 = first, 1 = last
+        float spread = 0.0f; // stereo spread, 0 = every voice centred
+        int unison = 1; // detuned copies per note
+        float detune = 20.0f; // cents, outermost unison copy either side
+    };
+
+    static bool isRenderCommand(const juce::StringArray& args)
+    {
+        return args.contains("--render");
+    }
+
+    /**
+    Parses args and renders. Prints progress to stdout and problems to
+    stderr; returns the process exit code.
+    */
+    static int runFromCommandLine(const juce::StringArray& args)
+    {
+        Settings settings;
+        const int idx = args.indexOf("--render");
+
+        if (idx < 0 || idx + 2 >= args.size())
+        {
+            std::cerr << "Usage: --render <input.mid> <output.wav> [--attack s] [--decay s] "
+                         "[--sustain 0-1] [--release s] [--level 0-1] [--sample-rate hz] "
+                         "[--block-size samples] [--tail s] [--threads n] "
+                         "[--interpolation truncate|linear|hermite|lagrange] "
+                         "[--wavetable file.wav] [--frame-size samples] [--position 0-1] "
+                         "[--spread 0-1] [--unison copies] [--detune cents]" << std::endl;
+            return 1;
+        }
+
+        settings.input = juce::File::getCurrentWorkingDirectory().getChildFile(args[idx + 1].unquoted());
+        settings.output = juce::File::getCurrentWorkingDirectory().getChildFile(args[idx + 2].unquoted());
+        settings.envelope.attack = (float) getOption(args, "--attack", settings.envelope.attack);
+        settings.envelope.decay = (float) getOption(args, "--decay", settings.envelope.decay);
+        settings.envelope.sustain = (float) getOption(args, "--sustain", settings.envelope.sustain);
+        settings.envelope.release = (float) getOption(args, "--release", settings.envelope.release);
+        settings.level = (float) getOption(args, "--level", settings.level);
+        settings.sample_rate = getOption(args, "--sample-rate", settings.sample_rate);
+        settings.block_size = (int) getOption(args, "--block-size", settings.block_size);
+        settings.tail_seconds = getOption(args, "--tail", settings.tail_seconds);
+        settings.render_threads = (int) getOption(args, "--threads", settings.render_threads);
+
+        settings.frame_size = (int) getOption(args, "--frame-size", settings.frame_size);
+        settings.position = (float) getOption(args, "--position", settings.position);
+        settings.spread = (float) getOption(args, "--spread", settings.spread);
+        settings.unison = (int) getOption(args, "--unison", settings.unison);
+        settings.detune = (float) getOption(args, "--detune", settings.detune);
+
+        const int wavetable_idx = args.indexOf("--wavetable");
+        if (wavetable_idx >= 0 && wavetable_idx + 1 < args.size())
+            settings.wavetable = juce::File::getCurrentWorkingDirectory().getChildFile(args[wavetable_idx + 1].unquoted());
+
+        const int quality_idx = args.indexOf("--interpolation");
+        if (quality_idx >= 0 && ! parseInterpolation(args[quality_idx + 1], settings.interpolation))
+        {
+            std::cerr << "Unknown interpolation " << args[quality_idx + 1] << std::endl;
+            return 1;
+        }
+
+        juce::String error;
+        if (! render(settings, error))
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /** Reads every track of a MIDI file into one sequence timed in seconds. */
+    static bool readMidiFile(const juce::File& file, juce::MidiMessageSequence& sequence,
+                             juce::String& error)
+    {
+        juce::FileInputStream stream(file);
+        juce::MidiFile midi;
+
+        if (! stream.openedOk() || ! midi.readFrom(stream))
+        {
+            error = "Couldn't read MIDI file " + file.getFullPathName();
+            return false;
+        }
+
+        midi.convertTimestampTicksToSeconds();
+
+        sequence.clear();
+        for (int track = 0; track < midi.getNumTracks(); ++track)
+            sequence.addSequence(*midi.getTrack(track), 0.0);
+
+        sequence.sort();
+        return true;
+    }
+
+    /**
+    Renders settings.input to settings.output. On failure returns false and
+    describes the problem in error.
+    */
+    static bool render(const Settings& settings, juce::String& error)
+    {
+        juce::MidiMessageSequence sequence;
+        if (! readMidiFile(settings.input, sequence, error))
+            return false;
+
+        if (settings.sample_rate <= 0.0 || settings.block_size <= 0)
+        {
+            error = "Sample rate and block size must be positive";
+            return false;
+        }
+
+        // Every input is read before the output is touched, so a bad one leaves it as it was
+        SynthEngine engine;
+        engine.setNumRenderThreads(settings.render_threads);
+
+        if (settings.wavetable != juce::File())
+        {
+            // Built inline: an offline render can wait for it
+            auto table = WavetableLoader::load(settings.wavetable, VoiceBank::kTableSize, error,
+                                               settings.frame_size);
+            if (table == nullptr)
+                return false;
+
+            if (error.isNotEmpty())
+            {
+                std::cerr << error << std::endl; // a bank cut short still renders
+                error.clear();
+            }
+
+            engine.setWavetable(table);
+        }
+
+        settings.output.deleteFile();
+        auto stream = settings.output.createOutputStream();
+        if (stream == nullptr || ! stream->openedOk())
+        {
+            error = "Couldn't open " + settings.output.getFullPathName() + " for writing";
+            return false;
+        }
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(stream.get(), settings.sample_rate, kNumChannels,
+                                settings.bit_depth, {}, 0));
+        if (writer == nullptr)
+        {
+            error = "Couldn't create a WAV writer";
+            return false;
+        }
+        stream.release(); // now owned by the writer
+
+        auto& params = engine.getParameters();
+        params.setAttack(settings.envelope.attack);
+        params.setDecay(settings.envelope.decay);
+        params.setSustain(settings.envelope.sustain);
+        params.setRelease(settings.envelope.release);
+        params.setLevel(settings.level);
+        params.setInterpolation(settings.interpolation);
+        params.setPosition(settings.position);
+        params.setStereoSpread(settings.spread);
+        params.setUnison(settings.unison);
+        params.setUnisonDetune(settings.detune);
+        engine.prepareToPlay(settings.block_size, settings.sample_rate);
+
+        const auto total_samples = (juce::int64) std::ceil((sequence.getEndTime() + settings.tail_seconds)
+                                                           * settings.sample_rate);
+        juce::AudioBuffer<float> buffer(kNumChannels, settings.block_size);
+        juce::MidiBuffer events;
+        int next_event = 0;
+
+        const auto start_time = juce::Time::getMillisecondCounterHiRes();
+
+        for (juce::int64 position = 0; position < total_samples; position += settings.block_size)
+        {
+            const int num_samples = (int) juce::jmin((juce::int64) settings.block_size,
+                                                     total_samples - position);
+
+            events.clear();
+            for (; next_event < sequence.getNumEvents(); ++next_event)
+            {
+                const auto& message = sequence.getEventPointer(next_event)->message;
+                const auto sample = (juce::int64) std::llround(message.getTimeStamp() * settings.sample_rate);
+
+                if (sample >= position + num_samples)
+                    break;
+
+                events.addEvent(message, (int) juce::jmax((juce::int64) 0, sample - position));
+            }
+
+            engine.renderNextBlock(juce::AudioSourceChannelInfo(&buffer, 0, num_samples), events);
+
+            if (! writer->writeFromAudioSampleBuffer(buffer, 0, num_samples))
+            {
+                error = "Couldn't write to " + settings.output.getFullPathName();
+                return false;
+            }
+        }
+
+        const auto elapsed = (juce::Time::getMillisecondCounterHiRes() - start_time) * 0.001;
+        const auto duration = (double) total_samples / settings.sample_rate;
+
+        std::cout << "Rendered " << duration << " s to " << settings.output.getFullPathName()
+                  << " in " << elapsed << " s ("
+                  << (elapsed > 0.0 ? duration / elapsed : 0.0) << "x realtime)" << std::endl;
+        return true;
+    }
+
+private:
+    static constexpr int kNumChannels = 2;
+
+    /** The number following name in args, or fallback. */
+    static double getOption(const juce::StringArray& args, const juce::String& name, double fallback)
+    {
+        const int idx = args.indexOf(name);
+        return idx >= 0 && idx + 1 < args.size() ? args[idx + 1].getDoubleValue() : fallback;
+    }
+};
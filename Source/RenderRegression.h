@@ -0,0 +1,565 @@
+/*
+  ==============================================================================
+
+    RenderRegression.h
+    Created: 17 Oct 2026 11:58:16pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SynthEngine.h"
+#include "WavetableSynth.h"
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/**
+Headless golden-output checks for the render path.
+
+    --regression <directory> [--update] [--tolerance 1e-4]
+
+A fixed set of scripted scenarios (note sequences, envelope and voice
+settings) is rendered through SynthEngine, which is what SynthKeyboard
+plays, and through a lone WavetableSynth, at each of kSampleRates. Every
+render is checked two ways:
+
+    golden  the render at kReferenceBlockSize is compared with the stored
+            reference <directory>/<scenario>-<rate>.wav; any sample further
+            than --tolerance from it fails
+    splits  the same scenario rendered at each of kSplitBlockSizes must
+            be identical to the reference-block-size render, sample for
+            sample, so block boundaries never change the sound (the
+            kernels have no scalar tails and VoiceBank frees voices on a
+            fixed sample clock, so this holds bit for bit)
+
+Events are placed at exact sample positions, and the render pool sums its
+groups in a fixed order, so renders are repeatable with or without render
+threads. The tolerance allows for the summation order of different SIMD
+widths; anything audible is far above it.
+
+The references are committed under Tests/golden, so a checkout is run as
+
+    --regression Tests/golden
+
+A scenario with no reference fails. --update records every reference from
+the current build (the split check still runs); do that only for a new
+scenario or after an intended change to the sound, from a build that has
+been checked by ear, and commit the files it writes. Exits with 1 if any
+check fails or a reference is missing or can't be read or written.
+*/
+class RenderRegression
+{
+public:
+    static constexpr double kSampleRates[] = { 44100.0, 48000.0, 96000.0 };
+    static constexpr int kReferenceBlockSize = 512;
+    static constexpr int kSplitBlockSizes[] = { 1, 17, 64, 500, 4096 };
+    static constexpr int kNumChannels = 2;
+
+    struct Settings
+    {
+        juce::File directory;
+        bool update = false;
+        double tolerance = 1.0e-4;
+    };
+
+    /** One scripted render. Times are in seconds from the start. */
+    struct Scenario
+    {
+        struct Event
+        {
+            double time;
+            juce::MidiMessage message;
+        };
+
+        Scenario(const juce::String& scenarioName, double length)
+            : name(scenarioName), seconds(length)
+        {
+        }
+
+        juce::String name;
+        double seconds = 1.0;
+        std::function<void(SynthEngine&)> setup; // parameters and wavetable, before prepareToPlay()
+        std::vector<Event> events;
+        bool oscillator = false; // play note events on one WavetableSynth instead of the engine
+        ADSREnvelope::Parameters envelope;
+    };
+
+    static bool isRegressionCommand(const juce::StringArray& args)
+    {
+        return args.contains("--regression");
+    }
+
+    /** Parses args and runs every check; returns the process exit code. */
+    static int runFromCommandLine(const juce::StringArray& args)
+    {
+        const int idx = args.indexOf("--regression");
+        if (idx < 0 || idx + 1 >= args.size())
+        {
+            std::cerr << "Usage: --regression <directory> [--update] [--tolerance 1e-4]" << std::endl;
+            return 1;
+        }
+
+        Settings settings;
+        settings.directory = juce::File::getCurrentWorkingDirectory().getChildFile(args[idx + 1].unquoted());
+        settings.update = args.contains("--update");
+
+        const int tolerance_idx = args.indexOf("--tolerance");
+        if (tolerance_idx >= 0 && tolerance_idx + 1 < args.size())
+            settings.tolerance = args[tolerance_idx + 1].getDoubleValue();
+
+        if (settings.directory.createDirectory().failed())
+        {
+            std::cerr << "Couldn't create " << settings.directory.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        int failures = 0;
+
+        for (const auto& scenario : getScenarios())
+            for (const auto sample_rate : kSampleRates)
+                failures += check(scenario, sample_rate, settings) ? 0 : 1;
+
+        std::cout << (failures == 0 ? juce::String("All renders match")
+                                    : juce::String(failures) + " render(s) failed") << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    //==========================================================================
+    /** The scripted scenarios, in the order they are checked. */
+    static std::vector<Scenario> getScenarios()
+    {
+        std::vector<Scenario> scenarios;
+
+        {
+            Scenario chord { "chord", 1.0 };
+            chord.setup = [](SynthEngine& engine)
+            {
+                setEnvelope(engine.getParameters(), { 0.01f, 0.1f, 0.7f, 0.2f });
+            };
+            chord.events = { { 0.00, juce::MidiMessage::noteOn(1, 60, 0.8f) },
+                             { 0.05, juce::MidiMessage::noteOn(1, 64, 0.6f) },
+                             { 0.10, juce::MidiMessage::noteOn(1, 67, 1.0f) },
+                             { 0.60, juce::MidiMessage::noteOff(1, 60) },
+                             { 0.60, juce::MidiMessage::noteOff(1, 64) },
+                             { 0.65, juce::MidiMessage::noteOff(1, 67) } };
+            scenarios.push_back(chord);
+        }
+
+        {
+            // Short notes held by the pedal, released together when it lifts
+            Scenario pedal { "pedal", 1.0 };
+            pedal.setup = [](SynthEngine& engine)
+            {
+                setEnvelope(engine.getParameters(), { 0.005f, 0.05f, 0.5f, 0.1f });
+            };
+            pedal.events.push_back({ 0.0, juce::MidiMessage::controllerEvent(1, 64, 127) });
+            for (int step = 0; step < 8; ++step)
+            {
+                const auto time = 0.05 * step;
+                pedal.events.push_back({ time, juce::MidiMessage::noteOn(1, 48 + 5 * step, 0.7f) });
+                pedal.events.push_back({ time + 0.03, juce::MidiMessage::noteOff(1, 48 + 5 * step) });
+            }
+            pedal.events.push_back({ 0.5, juce::MidiMessage::controllerEvent(1, 64, 0) });
+            scenarios.push_back(pedal);
+        }
+
+        {
+            // More notes than voices, so the quietest ones are stolen
+            Scenario steal { "steal", 0.8 };
+            steal.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.02f, 0.2f, 0.4f, 0.1f });
+                params.setMaxVoices(4);
+                params.setStealPolicy(VoiceStealPolicy::quietest);
+            };
+            for (int step = 0; step < 10; ++step)
+                steal.events.push_back({ 0.03 * step, juce::MidiMessage::noteOn(1, 40 + 3 * step, 0.5f + 0.05f * step) });
+            for (int step = 0; step < 10; ++step)
+                steal.events.push_back({ 0.5, juce::MidiMessage::noteOff(1, 40 + 3 * step) });
+            scenarios.push_back(steal);
+        }
+
+        {
+            // A chord landing on one sample in a full bank: all three notes must sound
+            Scenario chordSteal { "chordsteal", 0.6 };
+            chordSteal.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.05f, 0.1f, 0.6f, 0.1f });
+                params.setMaxVoices(4);
+                params.setStealPolicy(VoiceStealPolicy::quietest);
+            };
+            for (int step = 0; step < 4; ++step)
+                chordSteal.events.push_back({ 0.0, juce::MidiMessage::noteOn(1, 36 + 7 * step, 0.6f) });
+            for (const int note : { 72, 76, 79 })
+                chordSteal.events.push_back({ 0.2, juce::MidiMessage::noteOn(1, note, 0.8f) });
+            for (const int note : { 36, 43, 50, 57, 72, 76, 79 })
+                chordSteal.events.push_back({ 0.45, juce::MidiMessage::noteOff(1, note) });
+            scenarios.push_back(chordSteal);
+        }
+
+        {
+            // Detuned saw stacks spread across the field, read with Hermite
+            Scenario supersaw { "supersaw", 0.8 };
+            supersaw.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.01f, 0.1f, 0.8f, 0.15f });
+                params.setUnison(7);
+                params.setUnisonDetune(25.0f);
+                params.setStereoSpread(1.0f);
+                params.setInterpolation(Interpolation::hermite);
+                engine.setWavetable(WavetableCache::getInstance().get(Waveform::saw, VoiceBank::kTableSize));
+            };
+            supersaw.events = { { 0.00, juce::MidiMessage::noteOn(1, 57, 0.9f) },
+                                { 0.00, juce::MidiMessage::noteOn(1, 64, 0.9f) },
+                                { 0.40, juce::MidiMessage::noteOff(1, 57) },
+                                { 0.45, juce::MidiMessage::noteOff(1, 64) } };
+            scenarios.push_back(supersaw);
+        }
+
+        {
+            // Two channels panned apart, read with Lagrange
+            Scenario pan { "pan", 0.8 };
+            pan.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.01f, 0.05f, 0.9f, 0.1f });
+                params.setInterpolation(Interpolation::lagrange);
+                engine.setWavetable(WavetableCache::getInstance().get(Waveform::square, VoiceBank::kTableSize));
+            };
+            pan.events = { { 0.00, juce::MidiMessage::controllerEvent(1, 10, 16) },
+                           { 0.00, juce::MidiMessage::controllerEvent(2, 10, 112) },
+                           { 0.01, juce::MidiMessage::noteOn(1, 72, 0.8f) },
+                           { 0.02, juce::MidiMessage::noteOn(2, 76, 0.8f) },
+                           { 0.30, juce::MidiMessage::controllerEvent(1, 10, 64) },
+                           { 0.50, juce::MidiMessage::noteOff(1, 72) },
+                           { 0.50, juce::MidiMessage::noteOff(2, 76) } };
+            scenarios.push_back(pan);
+        }
+
+        {
+            // Two MPE notes bent, pressed and morphed apart under a master bend
+            Scenario mpe { "mpe", 0.8 };
+            mpe.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.01f, 0.1f, 0.8f, 0.1f });
+                params.setPosition(0.25f);
+                engine.setWavetable(getMorphTable());
+            };
+            // RPN 0 on a member channel: a 24 semitone bend range for every note
+            mpe.events = { { 0.00, juce::MidiMessage::controllerEvent(2, 101, 0) },
+                           { 0.00, juce::MidiMessage::controllerEvent(2, 100, 0) },
+                           { 0.00, juce::MidiMessage::controllerEvent(2, 6, 24) },
+                           { 0.01, juce::MidiMessage::noteOn(2, 60, 0.8f) },
+                           { 0.01, juce::MidiMessage::noteOn(3, 67, 0.7f) } };
+            for (int step = 0; step < 30; ++step)
+            {
+                // A glide and a swell every 10 ms, as a controller streams them
+                const auto time = 0.05 + 0.01 * step;
+                mpe.events.push_back({ time, juce::MidiMessage::pitchWheel(2, 8192 + 100 * step) });
+                mpe.events.push_back({ time, juce::MidiMessage::channelPressureChange(3, 4 * step) });
+                mpe.events.push_back({ time, juce::MidiMessage::controllerEvent(2, 74, 64 + 2 * step) });
+                if (step == 15)
+                    mpe.events.push_back({ time, juce::MidiMessage::controllerEvent(3, 74, 10) });
+            }
+            mpe.events.push_back({ 0.40, juce::MidiMessage::pitchWheel(1, 4096) });
+            mpe.events.push_back({ 0.60, juce::MidiMessage::noteOff(2, 60) });
+            mpe.events.push_back({ 0.60, juce::MidiMessage::noteOff(3, 67) });
+            scenarios.push_back(mpe);
+        }
+
+        {
+            // Enough unison voices to cross the parallel threshold, rendered by two workers
+            Scenario pool { "pool", 0.5 };
+            pool.setup = [](SynthEngine& engine)
+            {
+                auto& params = engine.getParameters();
+                setEnvelope(params, { 0.01f, 0.1f, 0.7f, 0.1f });
+                params.setMaxVoices(128);
+                params.setUnison(16);
+                params.setUnisonDetune(15.0f);
+                params.setStereoSpread(0.8f);
+                engine.setWavetable(WavetableCache::getInstance().get(Waveform::saw, VoiceBank::kTableSize));
+                engine.setNumRenderThreads(2);
+            };
+            for (int step = 0; step < 6; ++step)
+                pool.events.push_back({ 0.01 * step, juce::MidiMessage::noteOn(1, 48 + 4 * step, 0.7f) });
+            for (int step = 0; step < 6; ++step)
+                pool.events.push_back({ 0.30, juce::MidiMessage::noteOff(1, 48 + 4 * step) });
+            scenarios.push_back(pool);
+        }
+
+        {
+            Scenario oscillator { "oscillator", 0.7 };
+            oscillator.oscillator = true;
+            oscillator.envelope = { 0.02f, 0.1f, 0.6f, 0.15f };
+            oscillator.events = { { 0.01, juce::MidiMessage::noteOn(1, 69, 1.0f) },
+                                  { 0.40, juce::MidiMessage::noteOff(1, 69) } };
+            scenarios.push_back(oscillator);
+        }
+
+        return scenarios;
+    }
+
+    /** Renders scenario from the start in blocks of blockSize samples. */
+    static juce::AudioBuffer<float> render(const Scenario& scenario, double sampleRate, int blockSize)
+    {
+        const auto total = (int) std::ceil(scenario.seconds * sampleRate);
+        juce::AudioBuffer<float> output(kNumChannels, total);
+
+        if (scenario.oscillator)
+            renderOscillator(scenario, sampleRate, blockSize, output);
+        else
+            renderEngine(scenario, sampleRate, blockSize, output);
+
+        return output;
+    }
+
+    /** The largest difference between any two corresponding samples; infinite if the shapes differ. */
+    static double getMaxDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return std::numeric_limits<double>::infinity();
+
+        double difference = 0.0;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+        {
+            const auto* x = a.getReadPointer(channel);
+            const auto* y = b.getReadPointer(channel);
+
+            for (int idx = 0; idx < a.getNumSamples(); ++idx)
+                difference = juce::jmax(difference, (double) std::abs(x[idx] - y[idx]));
+        }
+
+        return difference;
+    }
+
+private:
+    static void setEnvelope(SynthParameters& params, const ADSREnvelope::Parameters& envelope)
+    {
+        params.setAttack(envelope.attack);
+        params.setDecay(envelope.decay);
+        params.setSustain(envelope.sustain);
+        params.setRelease(envelope.release);
+    }
+
+    /**
+    A four-frame table from a sine to a bright harmonic stack, generated
+    here so the MPE scenario doesn't depend on a file. The file is only its
+    key in WavetableCache; nothing is read from it.
+    */
+    static SharedWavetable::Ptr getMorphTable()
+    {
+        constexpr int kNumFrames = 4;
+        constexpr int kCycleLength = 2048;
+
+        const auto key = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                             .getChildFile("RenderRegression-morph.wav");
+
+        auto& cache = WavetableCache::getInstance();
+
+        if (auto cached = cache.find(key, VoiceBank::kTableSize); cached != nullptr)
+            return cached;
+
+        return cache.add(new SharedWavetable(key, VoiceBank::kTableSize, kNumFrames,
+            [](int frame, std::vector<float>& cycle)
+            {
+                cycle.assign((size_t) kCycleLength, 0.0f);
+
+                for (int harmonic = 1; harmonic <= 1 + 8 * frame; ++harmonic)
+                    for (int i = 0; i < kCycleLength; ++i)
+                    {
+                        const auto phase = (double) ((harmonic * i) % kCycleLength) / (double) kCycleLength;
+                        cycle[(size_t) i] += (float) (std::sin(juce::MathConstants<double>::twoPi * phase) / harmonic);
+                    }
+            }));
+    }
+
+    static int getSamplePosition(const Scenario::Event& event, double sampleRate)
+    {
+        return (int) std::llround(event.time * sampleRate);
+    }
+
+    static void renderEngine(const Scenario& scenario, double sampleRate, int blockSize,
+                             juce::AudioBuffer<float>& output)
+    {
+        SynthEngine engine;
+        if (scenario.setup != nullptr)
+            scenario.setup(engine);
+        engine.prepareToPlay(blockSize, sampleRate);
+
+        juce::MidiBuffer events;
+        size_t next_event = 0;
+
+        for (int position = 0; position < output.getNumSamples(); position += blockSize)
+        {
+            const int num_samples = juce::jmin(blockSize, output.getNumSamples() - position);
+
+            events.clear();
+            for (; next_event < scenario.events.size(); ++next_event)
+            {
+                const auto& event = scenario.events[next_event];
+                const int sample = getSamplePosition(event, sampleRate);
+
+                if (sample >= position + num_samples)
+                    break;
+
+                events.addEvent(event.message, juce::jmax(0, sample - position));
+            }
+
+            engine.renderNextBlock(juce::AudioSourceChannelInfo(&output, position, num_samples), events);
+        }
+    }
+
+    /** Splits each block at the events inside it, so the notes land on the same samples at any block size. */
+    static void renderOscillator(const Scenario& scenario, double sampleRate, int blockSize,
+                                 juce::AudioBuffer<float>& output)
+    {
+        WavetableSynth synth;
+        synth.setAttack(scenario.envelope.attack);
+        synth.setDecay(scenario.envelope.decay);
+        synth.setSustain(scenario.envelope.sustain);
+        synth.setRelease(scenario.envelope.release);
+        synth.prepareToPlay(blockSize, sampleRate);
+
+        size_t next_event = 0;
+
+        for (int position = 0; position < output.getNumSamples(); position += blockSize)
+        {
+            const int end = juce::jmin(position + blockSize, output.getNumSamples());
+            int start = position;
+
+            while (start < end)
+            {
+                int stop = end;
+
+                for (; next_event < scenario.events.size(); ++next_event)
+                {
+                    const auto& event = scenario.events[next_event];
+                    const int sample = getSamplePosition(event, sampleRate);
+
+                    if (sample > start)
+                    {
+                        stop = juce::jmin(stop, sample);
+                        break;
+                    }
+
+                    if (event.message.isNoteOn())
+                        synth.noteOn((float) NoteFrequencyTable::getFrequency(event.message.getNoteNumber()),
+                                     event.message.getFloatVelocity());
+                    else if (event.message.isNoteOff())
+                        synth.noteOff();
+                }
+
+                synth.getNextAudioBlock(juce::AudioSourceChannelInfo(&output, start, stop - start));
+                start = stop;
+            }
+        }
+    }
+
+    static bool check(const Scenario& scenario, double sampleRate, const Settings& settings)
+    {
+        const auto name = scenario.name + "-" + juce::String(juce::roundToInt(sampleRate));
+        const auto reference = render(scenario, sampleRate, kReferenceBlockSize);
+        bool passed = true;
+
+        juce::String line = name.paddedRight(' ', 20);
+
+        double split_difference = 0.0;
+        for (const int block_size : kSplitBlockSizes)
+            split_difference = juce::jmax(split_difference,
+                                          getMaxDifference(render(scenario, sampleRate, block_size), reference));
+
+        line << "splits " << juce::String(split_difference, 9);
+        if (split_difference != 0.0)
+        {
+            line << " FAILED";
+            passed = false;
+        }
+
+        const auto file = settings.directory.getChildFile(name + ".wav");
+
+        juce::AudioBuffer<float> golden;
+
+        if (settings.update)
+        {
+            if (writeReference(file, reference, sampleRate))
+            {
+                line << "  golden written";
+            }
+            else
+            {
+                line << "  couldn't write " << file.getFullPathName();
+                passed = false;
+            }
+        }
+        else if (! file.existsAsFile())
+        {
+            line << "  no reference; run with --update to record it FAILED";
+            passed = false;
+        }
+        else if (readReference(file, golden))
+        {
+            const auto difference = getMaxDifference(reference, golden);
+            line << "  golden " << juce::String(difference, 9);
+
+            if (difference > settings.tolerance)
+            {
+                line << " FAILED";
+                passed = false;
+            }
+        }
+        else
+        {
+            line << "  couldn't read " << file.getFullPathName();
+            passed = false;
+        }
+
+        std::cout << line << std::endl;
+        return passed;
+    }
+
+    /** Writes buffer as a 32-bit float WAV, so the reference is bit-exact. */
+    static bool writeReference(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+    {
+        file.deleteFile();
+        auto stream = file.createOutputStream();
+        if (stream == nullptr || ! stream->openedOk())
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(stream.get(), sampleRate, (unsigned int) buffer.getNumChannels(), 32, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release(); // now owned by the writer
+        return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    static bool readReference(const juce::File& file, juce::AudioBuffer<float>& buffer)
+    {
+        if (! file.existsAsFile())
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+        if (reader == nullptr)
+            return false;
+
+        buffer.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+    }
+};
@@ -0,0 +1,201 @@
+/*
+  ==============================================================================
+
+    SimdLanes.h
+    Created: 17 Oct 2026 1:37:22pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+//==============================================================================
+// GCC/Clang only emit AVX code inside functions that ask for it, so every
+// function that touches those intrinsics carries a target attribute. Kernels
+// written once against the Lanes* structs below are instantiated inside a
+// SIMD_KERNEL_* wrapper; "flatten" inlines the whole template into it so the
+// per-lane helpers compile down to straight-line vector code. MSVC allows the
+// intrinsics anywhere and needs none of this.
+
+#if JUCE_INTEL && ! JUCE_MSVC
+ #define SIMD_TARGET_AVX2      __attribute__((target("avx2,fma")))
+ #define SIMD_TARGET_AVX512    __attribute__((target("avx512f,avx2,fma")))
+ #define SIMD_KERNEL_AVX2      __attribute__((target("avx2,fma"), flatten))
+ #define SIMD_KERNEL_AVX512    __attribute__((target("avx512f,avx2,fma"), flatten))
+ #define SIMD_KERNEL_DEFAULT   __attribute__((flatten))
+
+ // Passing __m256/__m512 through the lane helpers trips GCC's ABI note even
+ // though no such call survives flattening.
+ #pragma GCC diagnostic ignored "-Wpsabi"
+#else
+ #define SIMD_TARGET_AVX2
+ #define SIMD_TARGET_AVX512
+ #define SIMD_KERNEL_AVX2
+ #define SIMD_KERNEL_AVX512
+ #define SIMD_KERNEL_DEFAULT
+#endif
+
+//==============================================================================
+/**
+Thin wrappers over one SIMD register of float lanes and one of int32 lanes.
+
+Each struct exposes the same static interface so a kernel can be written
+once as a template and instantiated for every instruction set. kWidth is the
+number of lanes. Integer adds wrap and srl is a logical shift, so Int lanes
+can also carry unsigned fixed-point values.
+*/
+struct LanesScalar
+{
+    static constexpr int kWidth = 1;
+    using Float = float;
+    using Int = juce::int32;
+
+    static forcedinline Float set1(float v) noexcept                   { return v; }
+    static forcedinline Int set1i(juce::int32 v) noexcept              { return v; }
+    static forcedinline Float load(const float* p) noexcept            { return *p; }
+    static forcedinline Int loadi(const juce::int32* p) noexcept       { return *p; }
+    static forcedinline void store(float* p, Float v) noexcept         { *p = v; }
+    static forcedinline Float add(Float a, Float b) noexcept           { return a + b; }
+    static forcedinline Float sub(Float a, Float b) noexcept           { return a - b; }
+    static forcedinline Float mul(Float a, Float b) noexcept           { return a * b; }
+    static forcedinline Float fmadd(Float a, Float b, Float c) noexcept { return a * b + c; }
+    static forcedinline Float max(Float a, Float b) noexcept           { return a > b ? a : b; }
+    static forcedinline void storei(juce::int32* p, Int v) noexcept    { *p = v; }
+    static forcedinline Int addi(Int a, Int b) noexcept                { return (Int) ((juce::uint32) a + (juce::uint32) b); }
+    static forcedinline Int andi(Int a, Int b) noexcept                { return a & b; }
+    static forcedinline Int srl(Int v, int bits) noexcept              { return (Int) ((juce::uint32) v >> bits); }
+    static forcedinline Int truncate(Float v) noexcept                 { return (juce::int32) v; }
+    static forcedinline Float toFloat(Int v) noexcept                  { return (float) v; }
+    static forcedinline Float gather(const float* base, Int idx) noexcept { return base[idx]; }
+    static forcedinline float sum(Float v) noexcept                    { return v; }
+};
+
+#if JUCE_INTEL
+struct LanesSSE2
+{
+    static constexpr int kWidth = 4;
+    using Float = __m128;
+    using Int = __m128i;
+
+    static forcedinline Float set1(float v) noexcept                   { return _mm_set1_ps(v); }
+    static forcedinline Int set1i(juce::int32 v) noexcept              { return _mm_set1_epi32(v); }
+    static forcedinline Float load(const float* p) noexcept            { return _mm_load_ps(p); }
+    static forcedinline Int loadi(const juce::int32* p) noexcept       { return _mm_load_si128((const __m128i*) p); }
+    static forcedinline void store(float* p, Float v) noexcept         { _mm_store_ps(p, v); }
+    static forcedinline Float add(Float a, Float b) noexcept           { return _mm_add_ps(a, b); }
+    static forcedinline Float sub(Float a, Float b) noexcept           { return _mm_sub_ps(a, b); }
+    static forcedinline Float mul(Float a, Float b) noexcept           { return _mm_mul_ps(a, b); }
+    static forcedinline Float fmadd(Float a, Float b, Float c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static forcedinline Float max(Float a, Float b) noexcept           { return _mm_max_ps(a, b); }
+    static forcedinline void storei(juce::int32* p, Int v) noexcept    { _mm_store_si128((__m128i*) p, v); }
+    static forcedinline Int addi(Int a, Int b) noexcept                { return _mm_add_epi32(a, b); }
+    static forcedinline Int andi(Int a, Int b) noexcept                { return _mm_and_si128(a, b); }
+    static forcedinline Int srl(Int v, int bits) noexcept              { return _mm_srl_epi32(v, _mm_cvtsi32_si128(bits)); }
+    static forcedinline Int truncate(Float v) noexcept                 { return _mm_cvttps_epi32(v); }
+    static forcedinline Float toFloat(Int v) noexcept                  { return _mm_cvtepi32_ps(v); }
+
+    static forcedinline Float gather(const float* base, Int idx) noexcept
+    {
+        alignas(16) juce::int32 index[4];
+        _mm_store_si128((__m128i*) index, idx);
+        return _mm_setr_ps(base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+    }
+
+    static forcedinline float sum(Float v) noexcept
+    {
+        auto pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+struct LanesAVX2
+{
+    static constexpr int kWidth = 8;
+    using Float = __m256;
+    using Int = __m256i;
+
+    SIMD_TARGET_AVX2 static inline Float set1(float v) noexcept                   { return _mm256_set1_ps(v); }
+    SIMD_TARGET_AVX2 static inline Int set1i(juce::int32 v) noexcept              { return _mm256_set1_epi32(v); }
+    SIMD_TARGET_AVX2 static inline Float load(const float* p) noexcept            { return _mm256_load_ps(p); }
+    SIMD_TARGET_AVX2 static inline Int loadi(const juce::int32* p) noexcept       { return _mm256_load_si256((const __m256i*) p); }
+    SIMD_TARGET_AVX2 static inline void store(float* p, Float v) noexcept         { _mm256_store_ps(p, v); }
+    SIMD_TARGET_AVX2 static inline Float add(Float a, Float b) noexcept           { return _mm256_add_ps(a, b); }
+    SIMD_TARGET_AVX2 static inline Float sub(Float a, Float b) noexcept           { return _mm256_sub_ps(a, b); }
+    SIMD_TARGET_AVX2 static inline Float mul(Float a, Float b) noexcept           { return _mm256_mul_ps(a, b); }
+    SIMD_TARGET_AVX2 static inline Float fmadd(Float a, Float b, Float c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    SIMD_TARGET_AVX2 static inline Float max(Float a, Float b) noexcept           { return _mm256_max_ps(a, b); }
+    SIMD_TARGET_AVX2 static inline void storei(juce::int32* p, Int v) noexcept    { _mm256_store_si256((__m256i*) p, v); }
+    SIMD_TARGET_AVX2 static inline Int addi(Int a, Int b) noexcept                { return _mm256_add_epi32(a, b); }
+    SIMD_TARGET_AVX2 static inline Int andi(Int a, Int b) noexcept                { return _mm256_and_si256(a, b); }
+    SIMD_TARGET_AVX2 static inline Int srl(Int v, int bits) noexcept              { return _mm256_srl_epi32(v, _mm_cvtsi32_si128(bits)); }
+    SIMD_TARGET_AVX2 static inline Int truncate(Float v) noexcept                 { return _mm256_cvttps_epi32(v); }
+    SIMD_TARGET_AVX2 static inline Float toFloat(Int v) noexcept                  { return _mm256_cvtepi32_ps(v); }
+    SIMD_TARGET_AVX2 static inline Float gather(const float* base, Int idx) noexcept { return _mm256_i32gather_ps(base, idx, 4); }
+
+    SIMD_TARGET_AVX2 static inline float sum(Float v) noexcept
+    {
+        return LanesSSE2::sum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+};
+
+struct LanesAVX512
+{
+    static constexpr int kWidth = 16;
+    using Float = __m512;
+    using Int = __m512i;
+
+    SIMD_TARGET_AVX512 static inline Float set1(float v) noexcept                   { return _mm512_set1_ps(v); }
+    SIMD_TARGET_AVX512 static inline Int set1i(juce::int32 v) noexcept              { return _mm512_set1_epi32(v); }
+    SIMD_TARGET_AVX512 static inline Float load(const float* p) noexcept            { return _mm512_load_ps(p); }
+    SIMD_TARGET_AVX512 static inline Int loadi(const juce::int32* p) noexcept       { return _mm512_load_si512(p); }
+    SIMD_TARGET_AVX512 static inline void store(float* p, Float v) noexcept         { _mm512_store_ps(p, v); }
+    SIMD_TARGET_AVX512 static inline Float add(Float a, Float b) noexcept           { return _mm512_add_ps(a, b); }
+    SIMD_TARGET_AVX512 static inline Float sub(Float a, Float b) noexcept           { return _mm512_sub_ps(a, b); }
+    SIMD_TARGET_AVX512 static inline Float mul(Float a, Float b) noexcept           { return _mm512_mul_ps(a, b); }
+    SIMD_TARGET_AVX512 static inline Float fmadd(Float a, Float b, Float c) noexcept { return _mm512_fmadd_ps(a, b, c); }
+    SIMD_TARGET_AVX512 static inline Float max(Float a, Float b) noexcept           { return _mm512_max_ps(a, b); }
+    SIMD_TARGET_AVX512 static inline void storei(juce::int32* p, Int v) noexcept    { _mm512_store_si512(p, v); }
+    SIMD_TARGET_AVX512 static inline Int addi(Int a, Int b) noexcept                { return _mm512_add_epi32(a, b); }
+    SIMD_TARGET_AVX512 static inline Int andi(Int a, Int b) noexcept                { return _mm512_and_si512(a, b); }
+    SIMD_TARGET_AVX512 static inline Int srl(Int v, int bits) noexcept              { return _mm512_srl_epi32(v, _mm_cvtsi32_si128(bits)); }
+    SIMD_TARGET_AVX512 static inline Int truncate(Float v) noexcept                 { return _mm512_cvttps_epi32(v); }
+    SIMD_TARGET_AVX512 static inline Float toFloat(Int v) noexcept                  { return _mm512_cvtepi32_ps(v); }
+    SIMD_TARGET_AVX512 static inline Float gather(const float* base, Int idx) noexcept { return _mm512_i32gather_ps(idx, base, 4); }
+    SIMD_TARGET_AVX512 static inline float sum(Float v) noexcept                    { return _mm512_reduce_add_ps(v); }
+};
+#endif
+
+//==============================================================================
+/**
+Which of the Lanes* implementations the running CPU can use, widest first.
+*/
+enum class SimdLevel
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+inline SimdLevel detectSimdLevel() noexcept
+{
+   #if JUCE_INTEL
+    if (juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return SimdLevel::avx512;
+
+    if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+        return SimdLevel::avx2;
+
+    if (juce::SystemStats::hasSSE2())
+        return SimdLevel::sse2;
+   #endif
+
+    return SimdLevel::scalar;
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    StereoPan.h
+    Created: 17 Oct 2026 11:24:52pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cmath>
+
+//==============================================================================
+/**
+The pan law shared by every voice: a pan position from -1 (hard left) to 1
+(hard right) to a gain for each side.
+
+It is the constant-power (sine/cosine) law: the two gains' squares always
+sum to 1, so a voice sounds equally loud wherever it sits, and a centred
+voice is -3 dB on each side. Spreading a unison stack or the keyboard
+across the field therefore leaves its level alone.
+
+A mono device gets both sides summed and scaled by kMonoGain, which brings
+a centred voice back to unity.
+*/
+namespace StereoPan
+{
+    constexpr float kMonoGain = 0.70710678f; // 1 / sqrt(2)
+
+    inline void getGains(float pan, float& left, float& right) noexcept
+    {
+        const auto angle = (juce::jlimit(-1.0f, 1.0f, pan) + 1.0f) * juce::MathConstants<float>::halfPi * 0.5f;
+
+        // Exactly 0 on the far side at the edges
+        left = pan >= 1.0f ? 0.0f : std::cos(angle);
+        right = pan <= -1.0f ? 0.0f : std::sin(angle);
+    }
+
+    /** Maps a MIDI pan controller value (0 to 127, 64 is centre) to -1 to 1. */
+    inline float fromController(int value) noexcept
+    {
+        return juce::jlimit(-1.0f, 1.0f, (float) (value - 64) / 63.0f);
+    }
+
+    /**
+    Which of the two mixed sides a device channel gets: even channels are
+    left and odd ones right, so a 4-channel device plays the stereo pair
+    twice.
+    */
+    inline bool isLeftChannel(int channel) noexcept
+    {
+        return channel % 2 == 0;
+    }
+}
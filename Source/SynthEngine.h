@@ -0,0 +1,538 @@
+/*
+  ==============================================================================
+
+    SynthEngine.h
+    Created: 17 Oct 2026 6:14:52pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "VoiceBank.h"
+#include "NoteEventQueue.h"
+#include "SynthParameters.h"
+#include "WavetableLoader.h"
+#include "StereoPan.h"
+
+#include <atomic>
+
+//==============================================================================
+/**
+Everything that makes sound, with no UI and no audio device attached.
+
+Realtime use goes through the AudioSource interface: note events are posted
+from the keyboard or MIDI threads and scheduled into the next block.
+Offline use calls renderNextBlock() directly with a MidiBuffer of events
+already placed at their sample positions, as fast as the CPU allows.
+*/
+class SynthEngine  : public juce::AudioSource
+{
+public:
+    SynthEngine()
+        : mix_(kNumMixChannels, kDefaultBlockSize)
+    {
+    }
+
+    ~SynthEngine() override
+    {
+        loader_.stop();
+
+        if (auto* table = pending_wavetable_.exchange(nullptr, std::memory_order_acq_rel))
+            table->decReferenceCount();
+    }
+
+    /** The controls the UI writes to; safe to set from any thread. */
+    SynthParameters& getParameters() noexcept { return parameters_; }
+
+    int getNumActiveVoices() const noexcept { return bank_.getNumActiveVoices(); }
+
+    /**
+    Starts numWorkers real-time threads that help render blocks with many
+    voices, or with 0 goes back to rendering on the audio thread alone. Call
+    this while no audio is being rendered, e.g. before prepareToPlay().
+    */
+    void setNumRenderThreads(int numWorkers)
+    {
+        bank_.setRenderPool(nullptr);
+        pool_.reset();
+
+        if (numWorkers > 0)
+        {
+            pool_ = std::make_unique<VoiceRenderPool>(numWorkers);
+            bank_.setRenderPool(pool_.get());
+        }
+    }
+
+    int getNumRenderThreads() const noexcept { return pool_ != nullptr ? pool_->getNumWorkers() : 0; }
+
+    //==========================================================================
+    // Wavetables
+
+    /**
+    Hands every voice a new table at the start of the next block, sounding
+    notes included. Safe from any thread but the audio thread; if several
+    tables arrive within one block, the last wins. The table must come from
+    WavetableCache (or WavetableLoader), which keeps the old one alive so
+    the audio thread never frees it.
+    */
+    void setWavetable(SharedWavetable::Ptr table)
+    {
+        jassert(table != nullptr);
+
+        table->incReferenceCount(); // owned by the slot until the audio thread takes it
+
+        if (auto* replaced = pending_wavetable_.exchange(table.get(), std::memory_order_acq_rel))
+            replaced->decReferenceCount();
+    }
+
+    /**
+    Starts building the table in file on the loader thread, and swaps it in
+    once it is ready; the audio thread never waits for it. Problems, a bank
+    cut short included, are passed to onError on the loader thread. Call
+    from the message thread.
+
+    Each load first purges the cache of the banks nothing plays any more (by
+    then the audio thread has long taken the previous one), so a session
+    spent auditioning banks only keeps a few of them.
+    */
+    void loadWavetable(const juce::File& file, std::function<void(const juce::String&)> onError = nullptr)
+    {
+        WavetableCache::getInstance().purgeUnused(kUnusedTablesKept);
+
+        loader_.loadAsync(file, VoiceBank::kTableSize,
+                          [this, onError](SharedWavetable::Ptr table, const juce::String& error)
+        {
+            if (table != nullptr)
+                setWavetable(table);
+
+            if (error.isNotEmpty() && onError != nullptr)
+                onError(error);
+        });
+    }
+
+    /**
+    How many note and expression events are waiting in the input queues for
+    the next block; the queues hold kQueueCapacity each. Exact on the audio
+    thread, a snapshot anywhere else.
+    */
+    int getNumQueuedEvents() const noexcept
+    {
+        return keyboard_events_.getNumReady() + midi_events_.getNumReady();
+    }
+
+    /**
+    True if the last rendered block was silence that cost next to nothing:
+    no voice was sounding and no event arrived, so the region was cleared
+    and nothing was rendered. A host can skip any processing downstream of
+    the synth for such a block. Audio thread only.
+    */
+    bool isLastBlockSilent() const noexcept { return last_block_silent_; }
+
+    //==========================================================================
+    // Event input
+
+    /**
+    Call this from the MIDI input thread only. The message is stamped with
+    its arrival time and handed to the audio thread through its own
+    wait-free queue.
+
+    The stamp is taken here rather than from message.getTimeStamp() so that
+    it is on the same high-resolution clock the audio thread reads; some
+    drivers only stamp to the millisecond.
+
+    Per-note expression (pitch bend, channel pressure and the CC 74 timbre
+    controller) takes the same path. Each message is one fixed-size push, so
+    an MPE controller streaming thousands of them a second never allocates
+    or locks here. So do the (N)RPN controllers, which set the bend ranges:
+    RPN 0 (pitch bend sensitivity) and RPN 6 (the MPE configuration message).
+    */
+    void processMIDIMessage(const juce::MidiMessage& message)
+    {
+        if (message.isNoteOn())
+        {
+            midi_events_.push({ NoteEvent::Type::noteOn,
+                                (juce::uint8) message.getChannel(),
+                                (juce::uint8) message.getNoteNumber(),
+                                message.getFloatVelocity(),
+                                NoteEvent::now() });
+        }
+        else if (message.isNoteOff())
+        {
+            midi_events_.push({ NoteEvent::Type::noteOff,
+                                (juce::uint8) message.getChannel(),
+                                (juce::uint8) message.getNoteNumber(),
+                                message.getFloatVelocity(),
+                                NoteEvent::now() });
+        }
+        else if (message.isSustainPedalOn() || message.isSustainPedalOff())
+        {
+            midi_events_.push({ message.isSustainPedalOn() ? NoteEvent::Type::sustainOn
+                                                           : NoteEvent::Type::sustainOff,
+                                (juce::uint8) message.getChannel(),
+                                0,
+                                0.0f,
+                                NoteEvent::now() });
+        }
+        else if (message.isController() && (message.getControllerNumber() == kPanController
+                                            || message.getControllerNumber() == kTimbreController
+                                            || isParameterController(message.getControllerNumber())))
+        {
+            midi_events_.push({ NoteEvent::Type::controller,
+                                (juce::uint8) message.getChannel(),
+                                (juce::uint8) message.getControllerNumber(),
+                                (float) message.getControllerValue() / 127.0f,
+                                NoteEvent::now() });
+        }
+        else if (message.isPitchWheel())
+        {
+            midi_events_.push({ NoteEvent::Type::pitchBend,
+                                (juce::uint8) message.getChannel(),
+                                0,
+                                getPitchBend(message),
+                                NoteEvent::now() });
+        }
+        else if (message.isChannelPressure())
+        {
+            midi_events_.push({ NoteEvent::Type::pressure,
+                                (juce::uint8) message.getChannel(),
+                                0,
+                                (float) message.getChannelPressureValue() / 127.0f,
+                                NoteEvent::now() });
+        }
+    }
+
+    /** Call this from the message thread only (on-screen keyboard events). */
+    void postKeyboardEvent(const NoteEvent& event)
+    {
+        keyboard_events_.push(event);
+    }
+
+    //==========================================================================
+    // AudioSource
+
+    /**
+    The voice bank is a fixed-size member, and the event buffer (sized for two
+    full queues) and mix buffer are allocated here, so nothing is allocated on
+    the audio thread. Blocks longer than expected are rendered in pieces.
+    */
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override
+    {
+        sample_rate_ = sampleRate;
+        mix_.setSize(kNumMixChannels, juce::jmax(samplesPerBlockExpected, kDefaultBlockSize));
+        block_events_.ensureSize((size_t) (2 * kQueueCapacity * kBytesPerEvent));
+        bank_.setSampleRate(sampleRate);
+        envelope_ = parameters_.getEnvelope();
+        bank_.setEnvelope(envelope_);
+        master_gain_.reset(sampleRate, kGainRampSeconds);
+        master_gain_.setCurrentAndTargetValue(parameters_.getLevel());
+        keyboard_events_.clear();
+        midi_events_.clear();
+    }
+
+    void releaseResources() override
+    {
+        bank_.allNotesOff();
+    }
+
+    /**
+    Schedules the queued note events, then renders the block. No
+    allocation, locking or map lookups happen in here.
+
+    Each event is placed at the sample matching how long before this callback
+    it arrived, so events keep their relative timing inside a block and every
+    event is delayed by the same amount: one block, whatever the block size.
+    */
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
+    {
+        const auto now = NoteEvent::now();
+        const int num_samples = bufferToFill.numSamples;
+
+        block_events_.clear();
+        auto schedule_event = [&](const NoteEvent& event)
+        {
+            const auto age = juce::roundToInt((now - event.time) * sample_rate_);
+            block_events_.addEvent(event.toMidiMessage(),
+                                   juce::jlimit(0, juce::jmax(0, num_samples - 1), num_samples - age));
+        };
+        keyboard_events_.drain(schedule_event);
+        midi_events_.drain(schedule_event);
+
+        renderNextBlock(bufferToFill, block_events_);
+    }
+
+    //==========================================================================
+    /**
+    Picks up the parameters and any new wavetable, then overwrites the region with every sounding
+    voice, applying each event in events at its sample position.
+
+    Voices are mixed, already panned, into a stereo scratch buffer, and one
+    vectorised pass per channel then writes a side of it (with the master
+    gain) into the device buffer from startSample on, so the device buffer
+    is written exactly once and never cleared first.
+
+    Denormals are flushed to zero for the whole block. With no voice
+    sounding and no events the region is just cleared; the return value
+    (also kept for isLastBlockSilent()) says whether that happened.
+    */
+    bool renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill,
+                         const juce::MidiBuffer& events) noexcept
+    {
+        const juce::ScopedNoDenormals no_denormals;
+
+        if (auto* table = pending_wavetable_.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            bank_.setWavetable(table);
+            table->decReferenceCountWithoutDeleting(); // the slot's reference; the cache still holds one
+        }
+
+        // One snapshot per block; the coefficients are only rebuilt on change
+        const auto envelope = parameters_.getEnvelope();
+        if (envelope != envelope_)
+        {
+            envelope_ = envelope;
+            bank_.setEnvelope(envelope_);
+        }
+        master_gain_.setTargetValue(parameters_.getLevel());
+        bank_.setMaxVoices(parameters_.getMaxVoices());
+        bank_.setStealPolicy(parameters_.getStealPolicy());
+        bank_.setReleaseCullLevel(parameters_.getReleaseCullLevel());
+        bank_.setInterpolation(parameters_.getInterpolation());
+        bank_.setFramePosition(parameters_.getPosition());
+        bank_.setStereoSpread(parameters_.getStereoSpread());
+        bank_.setUnison(parameters_.getUnison(), parameters_.getUnisonDetune());
+
+        last_block_silent_ = bank_.getNumActiveVoices() == 0 && events.isEmpty();
+        if (last_block_silent_)
+        {
+            bufferToFill.clearActiveBufferRegion();
+            master_gain_.skip(bufferToFill.numSamples);
+            return true;
+        }
+
+        const int mix_size = mix_.getNumSamples();
+        auto* left = mix_.getWritePointer(0);
+        auto* right = mix_.getWritePointer(1);
+
+        int start = 0;
+        do
+        {
+            const int num = juce::jmin(mix_size, bufferToFill.numSamples - start);
+            const bool last = start + num >= bufferToFill.numSamples;
+
+            juce::FloatVectorOperations::clear(left, num);
+            juce::FloatVectorOperations::clear(right, num);
+            renderEvents(left, right, start, num, last, events);
+            writeToChannels(bufferToFill, start, num);
+            start += num;
+        }
+        while (start < bufferToFill.numSamples);
+
+        return false;
+    }
+
+private:
+    /**
+    Adds the numSamples samples starting at blockStart into left and right, applying
+    each event in events that falls in that range at its sample position:
+    rendering is split at every event offset. On the last piece of a block,
+    events at or past its end are applied after the last sample.
+
+    Expression events only set targets that the voices follow from the
+    bank's next control point on, so the render is only split at one when a
+    control point falls before it. A stream of them costs at most one split
+    per control interval, and the voices still follow them at the same
+    samples however the blocks are split.
+    */
+    void renderEvents(float* left, float* right, int blockStart, int numSamples, bool isLastPiece,
+                      const juce::MidiBuffer& events) noexcept
+    {
+        int position = 0;
+        auto event = blockStart == 0 ? events.cbegin() : events.findNextSamplePosition(blockStart);
+
+        for (; event != events.cend(); ++event)
+        {
+            const auto metadata = *event;
+
+            if (! isLastPiece && metadata.samplePosition >= blockStart + numSamples)
+                break;
+
+            const auto message = metadata.getMessage();
+            const int offset = juce::jlimit(position, numSamples, metadata.samplePosition - blockStart);
+
+            if (offset > position && (! isExpression(message)
+                                          || bank_.getSamplesToNextControlPoint() <= offset - position))
+            {
+                bank_.render(left + position, right + position, offset - position);
+                position = offset;
+            }
+
+            handleMidiEvent(message);
+        }
+
+        if (position < numSamples)
+            bank_.render(left + position, right + position, numSamples - position);
+    }
+
+    /**
+    Writes the stereo mix out to every channel, applying the master gain on
+    the way. A mono device gets the two sides folded together with
+    StereoPan::kMonoGain, which for a centred voice is the voice itself.
+    */
+    void writeToChannels(const juce::AudioSourceChannelInfo& bufferToFill, int offset,
+                         int numSamples) noexcept
+    {
+        const int num_channels = bufferToFill.buffer->getNumChannels();
+        const int start = bufferToFill.startSample + offset;
+        auto* left = mix_.getWritePointer(0);
+        const auto* right = mix_.getReadPointer(1);
+
+        auto gain = master_gain_.getTargetValue();
+        if (master_gain_.isSmoothing())
+        {
+            master_gain_.applyGain(mix_, numSamples);
+            gain = 1.0f;
+        }
+
+        if (num_channels == 1)
+        {
+            juce::FloatVectorOperations::add(left, right, numSamples);
+            juce::FloatVectorOperations::copyWithMultiply(bufferToFill.buffer->getWritePointer(0, start),
+                                                          left, StereoPan::kMonoGain * gain, numSamples);
+            return;
+        }
+
+        for (int chan_idx = 0; chan_idx < num_channels; ++chan_idx)
+            juce::FloatVectorOperations::copyWithMultiply(bufferToFill.buffer->getWritePointer(chan_idx, start),
+                                                          StereoPan::isLeftChannel(chan_idx) ? left : right,
+                                                          gain, numSamples);
+    }
+
+    void handleMidiEvent(const juce::MidiMessage& message) noexcept
+    {
+        if (message.isNoteOn())
+        {
+            bank_.noteOn(message.getChannel(), message.getNoteNumber(),
+                         kVoiceGain * message.getFloatVelocity());
+        }
+        else if (message.isNoteOff())
+        {
+            bank_.noteOff(message.getChannel(), message.getNoteNumber());
+        }
+        else if (message.isSustainPedalOn() || message.isSustainPedalOff())
+        {
+            bank_.setSustainPedal(message.getChannel(), message.isSustainPedalOn());
+        }
+        else if (message.isController() && message.getControllerNumber() == kPanController)
+        {
+            bank_.setChannelPan(message.getChannel(), StereoPan::fromController(message.getControllerValue()));
+        }
+        else if (message.isPitchWheel())
+        {
+            bank_.setPitchBend(message.getChannel(), getPitchBend(message));
+        }
+        else if (message.isChannelPressure())
+        {
+            bank_.setPressure(message.getChannel(), (float) message.getChannelPressureValue() / 127.0f);
+        }
+        else if (message.isController() && message.getControllerNumber() == kTimbreController)
+        {
+            // 64 is the centre, which leaves the voices at the shared wavetable position
+            bank_.setTimbre(message.getChannel(), (float) (message.getControllerValue() - 64) / 63.0f);
+        }
+        else if (message.isController() && isParameterController(message.getControllerNumber()))
+        {
+            juce::MidiRPNMessage rpn;
+
+            if (rpn_detector_.parseControllerMessage(message.getChannel(), message.getControllerNumber(),
+                                                     message.getControllerValue(), rpn)
+                  && ! rpn.isNRPN)
+                handleRegisteredParameter(rpn);
+        }
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+        {
+            bank_.allNotesOff();
+        }
+    }
+
+    /**
+    RPN 0 sets the bend range of the master channel, or (sent to any other
+    channel) of every member channel, as MPE asks. RPN 6, the MPE
+    configuration message, puts both back to the MPE defaults.
+    */
+    void handleRegisteredParameter(const juce::MidiRPNMessage& rpn) noexcept
+    {
+        if (rpn.parameterNumber == kBendRangeParameter)
+        {
+            // Semitones in the MSB and cents in the LSB, when one was sent first
+            const auto semitones = rpn.is14BitValue ? (float) (rpn.value >> 7) + (float) (rpn.value & 127) / 100.0f
+                                                    : (float) rpn.value;
+
+            if (rpn.channel == VoiceBank::kMasterChannel)
+                bank_.setPitchBendRanges(semitones, bank_.getNoteBendRange());
+            else
+                bank_.setPitchBendRanges(bank_.getMasterBendRange(), semitones);
+        }
+        else if (rpn.parameterNumber == kMpeConfigurationParameter && rpn.channel == VoiceBank::kMasterChannel)
+        {
+            bank_.setPitchBendRanges(VoiceBank::kDefaultMasterBendRange, VoiceBank::kDefaultNoteBendRange);
+        }
+    }
+
+    /**
+    Pitch bend, channel pressure, timbre or a bend range: messages VoiceBank
+    applies at its control points.
+    */
+    static bool isExpression(const juce::MidiMessage& message) noexcept
+    {
+        return message.isPitchWheel() || message.isChannelPressure()
+            || (message.isController() && (message.getControllerNumber() == kTimbreController
+                                           || isParameterController(message.getControllerNumber())));
+    }
+
+    /** Selects an (N)RPN or sends it data: CC 6, 38 and 98 to 101. */
+    static bool isParameterController(int controller) noexcept
+    {
+        return controller == 6 || controller == 38 || (controller >= 98 && controller <= 101);
+    }
+
+    /** A pitch wheel message's bend, from -1 to 1 with 8192 as the centre. */
+    static float getPitchBend(const juce::MidiMessage& message) noexcept
+    {
+        return juce::jlimit(-1.0f, 1.0f, (float) (message.getPitchWheelValue() - 8192) / 8192.0f);
+    }
+
+    static constexpr float kVoiceGain = 0.125f;
+    static constexpr double kGainRampSeconds = 0.05;
+    static constexpr int kQueueCapacity = 1024;
+    static constexpr int kBytesPerEvent = 16; // MidiBuffer header plus a short message
+    static constexpr int kDefaultBlockSize = 512;
+    static constexpr int kNumMixChannels = 2;
+    static constexpr int kPanController = 10;
+    static constexpr int kTimbreController = 74; // MPE's third dimension
+    static constexpr int kBendRangeParameter = 0; // RPN 0, pitch bend sensitivity
+    static constexpr int kMpeConfigurationParameter = 6; // RPN 6, the MPE configuration message
+    static constexpr int kUnusedTablesKept = 2; // recent banks kept for a quick switch back
+
+    SynthParameters parameters_; // any thread -> audio thread
+
+    std::unique_ptr<VoiceRenderPool> pool_;
+    VoiceBank bank_; // audio thread only
+    ADSREnvelope::Parameters envelope_; // audio thread only
+    juce::SmoothedValue<float> master_gain_; // audio thread only
+    juce::AudioBuffer<float> mix_; // left and right; audio thread only
+
+    NoteEventQueue keyboard_events_ { kQueueCapacity }; // message thread -> audio thread
+    NoteEventQueue midi_events_ { kQueueCapacity };     // MIDI input thread -> audio thread
+    juce::MidiBuffer block_events_; // audio thread only
+    juce::MidiRPNDetector rpn_detector_; // audio thread only
+    double sample_rate_ = 48000.0;
+    bool last_block_silent_ = false;
+
+    std::atomic<SharedWavetable*> pending_wavetable_ { nullptr }; // any thread -> audio thread
+    WavetableLoader loader_; // last, so its thread stops before anything it calls back into
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthEngine)
+};
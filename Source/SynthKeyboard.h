@@ -11,18 +11,24 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "WavetableSynth.h"
-
-#include <map>
-
-using std::unordered_map;
+#include "SynthEngine.h"
 
 //==============================================================================
 /*
+On-screen keyboard in front of the SynthEngine.
+
+Keys clicked here go through MidiKeyboardState to the engine. External MIDI
+bypasses MidiKeyboardState completely: it goes straight into the engine's
+lock-free queue, and the MIDI thread only flips a bit per held note. A timer
+on the message thread copies those bits into the keyboard display at most
+kDisplayRefreshRate times a second. How fast a note sounds therefore
+doesn't depend on the GUI, and a burst of MIDI costs the message thread at
+most one repaint per frame.
 */
 class SynthKeyboard  : public juce::Component,
                        public juce::MidiKeyboardState::Listener,
-                       public juce::AudioSource
+                       public juce::AudioSource,
+                       private juce::Timer
 {
 public:
     SynthKeyboard()
@@ -31,68 +37,69 @@ public:
         midi_keyboard_.reset(new juce::MidiKeyboardComponent(midi_keyboard_state_,
                             juce::KeyboardComponentBase::Orientation::horizontalKeyboard));
         addAndMakeVisible(midi_keyboard_.get());
+        startTimerHz(kDisplayRefreshRate);
+    }
+
+    virtual ~SynthKeyboard() override
+    {
+        stopTimer();
+        midi_keyboard_state_.removeListener(this);
     }
 
-    virtual ~SynthKeyboard() = default;
+    /** The controls the UI writes to; safe to set from any thread. */
+    SynthParameters& getParameters() noexcept { return engine_.getParameters(); }
+
+    SynthEngine& getEngine() noexcept { return engine_; }
 
     //==========================================================================
     // External MIDI
 
+    /**
+    Call this from the MIDI input thread only. The message goes to the
+    engine's queue, and held notes are noted for the display; nothing here
+    locks or waits for the message thread.
+    */
     void processMIDIMessage(const juce::MidiMessage& message)
     {
-        if (message.isNoteOn())
-        {
-            /* TODO
-            handleNoteOn(nullptr,
-                         message.getChannel(),
-                         message.getNoteNumber(),
-                         message.getVelocity());
-                         */
-        }
-        else if (message.isNoteOff())
-        {
-            /* TODO
-            handleNoteOff(nullptr,
-                          message.getChannel(),
-                          message.getNoteNumber(),
-                          message.getVelocity());
-                          */
-        }
+        engine_.processMIDIMessage(message);
+        trackExternalNote(message);
     }
- 
+
 
     //==========================================================================
     // AudioSource
- 
+
     virtual void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override
     {
-        // TODO
+        engine_.prepareToPlay(samplesPerBlockExpected, sampleRate);
     }
  
     virtual void releaseResources() override
     {
-        // TODO
+        engine_.releaseResources();
     }
 
     virtual void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
     {
-        // TODO
+        engine_.getNextAudioBlock(bufferToFill);
     }
 
     //==========================================================================
     // MidiKeyboardState::Listener
 
-    static constexpr inline float midiToFreq(juce::uint8 midi_note)
-    {
-        return 440.0 * std::pow(2.0, (midi_note - 69) / 12.0);
-    }
-
     virtual void handleNoteOn(juce::MidiKeyboardState *source,
                               int midiChannel,
                               int midiNoteNumber,
                               float velocity) override
     {
-        // TODO
+        if (showing_external_notes_)
+            return; // already sent to the engine by processMIDIMessage()
+
+        engine_.postKeyboardEvent({ NoteEvent::Type::noteOn,
+                                    (juce::uint8) midiChannel,
+                                    (juce::uint8) midiNoteNumber,
+                                    velocity,
+                                    NoteEvent::now() });
     }
 
     virtual void handleNoteOff(juce::MidiKeyboardState *source,
@@ -100,7 +107,14 @@ public:
                                int midiNoteNumber,
                                float velocity) override
     {
-        // TODO
+        if (showing_external_notes_)
+            return;
+
+        engine_.postKeyboardEvent({ NoteEvent::Type::noteOff,
+                                    (juce::uint8) midiChannel,
+                                    (juce::uint8) midiNoteNumber,
+                                    velocity,
+                                    NoteEvent::now() });
     }
 
     //==========================================================================
@@ -114,9 +128,78 @@ public:
     }
 
 private:
-    // TODO
+    static constexpr int kDisplayRefreshRate = 30; // Hz
+    static constexpr int kNumChannels = 16;
+    static constexpr int kNotesPerWord = 64;
+    static constexpr int kWordsPerChannel = 128 / kNotesPerWord;
+    static constexpr int kNumWords = kNumChannels * kWordsPerChannel;
+    static constexpr float kDisplayVelocity = 1.0f;
+
+    /** Sets or clears the held-note bits for a note on or off. MIDI input thread only. */
+    void trackExternalNote(const juce::MidiMessage& message) noexcept
+    {
+        const int channel = message.getChannel();
+        if (channel < 1 || channel > kNumChannels)
+            return;
+
+        const int first_word = (channel - 1) * kWordsPerChannel;
+
+        if (message.isNoteOn() || message.isNoteOff())
+        {
+            const int note = message.getNoteNumber();
+            auto& word = external_notes_[first_word + note / kNotesPerWord];
+            const auto bit = (juce::uint64) 1 << (note % kNotesPerWord);
+
+            if (message.isNoteOn())
+                word.fetch_or(bit, std::memory_order_relaxed);
+            else
+                word.fetch_and(~bit, std::memory_order_relaxed);
+        }
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+        {
+            for (int word = first_word; word < first_word + kWordsPerChannel; ++word)
+                external_notes_[word].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+    Brings the keyboard display up to date with the external notes that
+    changed since the last frame. The engine already has these notes, so the
+    listener callbacks they trigger are ignored.
+    */
+    void timerCallback() override
+    {
+        const juce::ScopedValueSetter<bool> showing(showing_external_notes_, true);
+
+        for (int word = 0; word < kNumWords; ++word)
+        {
+            const auto held = external_notes_[word].load(std::memory_order_relaxed);
+            auto changed = held ^ shown_notes_[word];
+            shown_notes_[word] = held;
+
+            const int channel = 1 + word / kWordsPerChannel;
+            const int first_note = (word % kWordsPerChannel) * kNotesPerWord;
+
+            for (int bit = 0; changed != 0; ++bit, changed >>= 1)
+            {
+                if ((changed & 1) == 0)
+                    continue;
+
+                if ((held >> bit) & 1)
+                    midi_keyboard_state_.noteOn(channel, first_note + bit, kDisplayVelocity);
+                else
+                    midi_keyboard_state_.noteOff(channel, first_note + bit, 0.0f);
+            }
+        }
+    }
+
+    SynthEngine engine_;
 
     juce::MidiKeyboardState midi_keyboard_state_;
     std::unique_ptr<juce::MidiKeyboardComponent> midi_keyboard_;
+
+    std::atomic<juce::uint64> external_notes_[kNumWords] {}; // MIDI input thread -> message thread
+    juce::uint64 shown_notes_[kNumWords] {}; // message thread only
+    bool showing_external_notes_ = false; // message thread only
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthKeyboard)
 };
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    SynthParameters.h
+    Created: 17 Oct 2026 5:32:40pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ADSREnvelope.h"
+#include "VoiceBank.h"
+
+#include <atomic>
+
+//==============================================================================
+/**
+The user-facing synth controls, shared between the message thread and the
+audio thread.
+
+Every field is a lock-free atomic float: the UI stores a value in O(1) no
+matter how many voices are sounding, and the audio thread loads a snapshot
+once per block. Fields are independent, so a block may see a new attack
+alongside an old decay, but never half of a float.
+*/
+class SynthParameters
+{
+public:
+    SynthParameters()
+    {
+        static_assert(std::atomic<float>::is_always_lock_free
+                        && std::atomic<int>::is_always_lock_free
+                        && std::atomic<VoiceStealPolicy>::is_always_lock_free
+                        && std::atomic<Interpolation>::is_always_lock_free,
+                      "Parameters are read on the audio thread and must not lock");
+    }
+
+    // Message thread
+    void setAttack(float seconds) noexcept  { attack_.store(seconds, std::memory_order_relaxed); }
+    void setDecay(float seconds) noexcept   { decay_.store(seconds, std::memory_order_relaxed); }
+    void setSustain(float level) noexcept   { sustain_.store(level, std::memory_order_relaxed); }
+    void setRelease(float seconds) noexcept { release_.store(seconds, std::memory_order_relaxed); }
+    void setLevel(float gain) noexcept      { level_.store(gain, std::memory_order_relaxed); }
+
+    void setMaxVoices(int maxVoices) noexcept              { max_voices_.store(maxVoices, std::memory_order_relaxed); }
+    void setStealPolicy(VoiceStealPolicy policy) noexcept  { steal_policy_.store(policy, std::memory_order_relaxed); }
+    void setReleaseCullLevel(float gain) noexcept          { release_cull_level_.store(gain, std::memory_order_relaxed); }
+    void setInterpolation(Interpolation quality) noexcept  { interpolation_.store(quality, std::memory_order_relaxed); }
+    void setPosition(float position) noexcept              { position_.store(position, std::memory_order_relaxed); }
+    void setStereoSpread(float spread) noexcept            { stereo_spread_.store(spread, std::memory_order_relaxed); }
+    void setUnison(int copies) noexcept                    { unison_.store(copies, std::memory_order_relaxed); }
+    void setUnisonDetune(float cents) noexcept             { unison_detune_.store(cents, std::memory_order_relaxed); }
+
+    // Audio thread
+    ADSREnvelope::Parameters getEnvelope() const noexcept
+    {
+        ADSREnvelope::Parameters params;
+        params.attack = attack_.load(std::memory_order_relaxed);
+        params.decay = decay_.load(std::memory_order_relaxed);
+        params.sustain = sustain_.load(std::memory_order_relaxed);
+        params.release = release_.load(std::memory_order_relaxed);
+        return params;
+    }
+
+    float getLevel() const noexcept { return level_.load(std::memory_order_relaxed); }
+
+    int getMaxVoices() const noexcept                { return max_voices_.load(std::memory_order_relaxed); }
+    VoiceStealPolicy getStealPolicy() const noexcept { return steal_policy_.load(std::memory_order_relaxed); }
+    float getReleaseCullLevel() const noexcept       { return release_cull_level_.load(std::memory_order_relaxed); }
+    Interpolation getInterpolation() const noexcept  { return interpolation_.load(std::memory_order_relaxed); }
+    float getPosition() const noexcept               { return position_.load(std::memory_order_relaxed); }
+    float getStereoSpread() const noexcept           { return stereo_spread_.load(std::memory_order_relaxed); }
+    int getUnison() const noexcept                   { return unison_.load(std::memory_order_relaxed); }
+    float getUnisonDetune() const noexcept           { return unison_detune_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<float> attack_ { 0.1f };
+    std::atomic<float> decay_ { 0.1f };
+    std::atomic<float> sustain_ { 0.9f };
+    std::atomic<float> release_ { 0.1f };
+    std::atomic<float> level_ { 0.8f };
+
+    // Bound the worst-case cost of a block
+    std::atomic<int> max_voices_ { 64 };
+    std::atomic<VoiceStealPolicy> steal_policy_ { VoiceStealPolicy::oldest };
+    std::atomic<float> release_cull_level_ { 1.0e-4f }; // -80 dB
+
+    // Cost against accuracy of every voice's table reads
+    std::atomic<Interpolation> interpolation_ { Interpolation::linear };
+    std::atomic<float> position_ { 0.0f }; // 0 = first wavetable frame, 1 = last
+    std::atomic<float> stereo_spread_ { 0.0f }; // 0 = every voice at its channel's pan, 1 = full width
+    std::atomic<int> unison_ { 1 }; // detuned copies per note
+    std::atomic<float> unison_detune_ { 20.0f }; // cents, outermost copy either side
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthParameters)
+};
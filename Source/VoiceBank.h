@@ -0,0 +1,1174 @@
+/*
+  ==============================================================================
+
+    VoiceBank.h
+    Created: 17 Oct 2026 2:05:40pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdLanes.h"
+#include "WavetableCache.h"
+#include "ADSREnvelope.h"
+#include "VoiceRenderPool.h"
+#include "NoteFrequencyTable.h"
+#include "Interpolation.h"
+#include "StereoPan.h"
+
+#include <cmath>
+
+//==============================================================================
+/**
+Per-voice oscillator and envelope state for every voice in a VoiceBank, laid
+out as structure-of-arrays so that one SIMD register holds the same field for
+4, 8 or 16 voices at once.
+
+Voices are kept packed: lanes [0, num_active) are sounding, everything after
+that is silent (zero amplitude, increment and envelope), so a partially
+filled final register renders silence without any masking.
+*/
+struct alignas(64) VoiceLaneState
+{
+    static constexpr int kMaxLanes = 256; // multiple of the widest register (16)
+
+    juce::uint32 phase[kMaxLanes];     // fixed point: the full 32-bit range is one cycle
+    juce::uint32 increment[kMaxLanes]; // phase step per sample, same scale
+    float amplitude[kMaxLanes];
+    float gain_left[kMaxLanes];  // amplitude times the pan gain for each side
+    float gain_right[kMaxLanes];
+    juce::int32 table_offset[kMaxLanes]; // start of the lane's mipmap level and frame
+    float frame_mix[kMaxLanes]; // weight of the next frame; 0 reads one frame only
+
+    // ADSREnvelope recursion, one per lane
+    float env_level[kMaxLanes];
+    float env_multiplier[kMaxLanes];
+    float env_offset[kMaxLanes];
+    juce::int32 env_samples_left[kMaxLanes];
+    juce::int32 env_stage[kMaxLanes];
+
+    void copyLane(int to, int from) noexcept
+    {
+        phase[to] = phase[from];
+        increment[to] = increment[from];
+        amplitude[to] = amplitude[from];
+        gain_left[to] = gain_left[from];
+        gain_right[to] = gain_right[from];
+        table_offset[to] = table_offset[from];
+        frame_mix[to] = frame_mix[from];
+        env_level[to] = env_level[from];
+        env_multiplier[to] = env_multiplier[from];
+        env_offset[to] = env_offset[from];
+        env_samples_left[to] = env_samples_left[from];
+        env_stage[to] = env_stage[from];
+    }
+
+    void clearLane(int lane) noexcept
+    {
+        phase[lane] = 0;
+        increment[lane] = 0;
+        amplitude[lane] = 0.0f;
+        gain_left[lane] = 0.0f;
+        gain_right[lane] = 0.0f;
+        table_offset[lane] = 0;
+        frame_mix[lane] = 0.0f;
+        env_level[lane] = 0.0f;
+        env_multiplier[lane] = 0.0f;
+        env_offset[lane] = 0.0f;
+        env_samples_left[lane] = ADSREnvelope::kForever;
+        env_stage[lane] = ADSREnvelope::idle;
+    }
+
+    /** Runs the envelope stage machine for one lane. */
+    void enterStage(const ADSREnvelope::Coefficients& coeffs, int lane, juce::int32 stage) noexcept
+    {
+        ADSREnvelope::enterStage(coeffs, stage, env_stage[lane], env_level[lane],
+                                 env_multiplier[lane], env_offset[lane], env_samples_left[lane]);
+    }
+
+    void finishStage(const ADSREnvelope::Coefficients& coeffs, int lane) noexcept
+    {
+        ADSREnvelope::finishStage(coeffs, env_stage[lane], env_level[lane],
+                                  env_multiplier[lane], env_offset[lane], env_samples_left[lane]);
+    }
+};
+
+//==============================================================================
+namespace VoiceBankKernels
+{
+    /** Samples rendered per pass; the lane accumulator for one pass stays in L1. */
+    static constexpr int kChunkSize = 128;
+    static constexpr int kMaxWidth = 16;
+    static constexpr int kAccumulatorSize = 2 * kChunkSize * kMaxWidth; // a left and right register per sample
+
+    /** Everything a render pass reads besides the lanes themselves. */
+    struct RenderContext
+    {
+        const float* table = nullptr; // level 0, frame 0; lanes add their own table_offset
+        int table_order = 0; // log2 of the table size
+        int frame_stride = 0; // from one frame to the next within a level
+        bool morph = false; // some lane has a frame_mix, so the next frame is read too
+        const ADSREnvelope::Coefficients* envelope = nullptr;
+        float* accumulator = nullptr; // kAccumulatorSize floats, 64-byte aligned
+    };
+
+    using RenderFunction = void (*)(VoiceLaneState& lanes, int beginLane, int endLane,
+                                    const RenderContext& context,
+                                    float* left, float* right, int numSamples);
+
+    /**
+    Adds the sum of lanes [beginLane, endLane) into left and right. Both must be
+    multiples of Lanes::kWidth. Each lane reads 2^table_order samples starting
+    at table + table_offset[lane], read through the Quality interpolation tier
+    (so the guard samples either side of the level are read too).
+
+    Phase is unsigned fixed point with one cycle spanning the whole 32 bits:
+    the table index is the top table_order bits, the interpolation fraction
+    the bits below, and the wrap is the integer add overflowing, so a voice
+    held for hours has exactly the pitch it started with.
+
+    Voices are processed one register (kWidth voices) at a time with their
+    phase and envelope held in registers across the whole chunk. Each lane's
+    oscillator times envelope is scaled by its left and right gains (its
+    amplitude and pan, fixed for the call) into a pair of kWidth-wide
+    accumulators per sample, which are reduced to the two output sides once
+    per sample after all voices have been added. Stereo therefore costs one
+    multiply-add per lane per sample and no extra pass over any buffer.
+
+    The envelope is one multiply-add per lane per sample. A register's run is
+    split wherever one of its lanes reaches the end of an envelope stage, so
+    stage changes stay sample-accurate without any per-sample branching.
+
+    With morph set, every lane also reads the same position in the next
+    frame (frame_stride further on, in the same level) and crossfades by its
+    own frame_mix, so voices can sit at different wavetable positions. The
+    choice between the one- and two-frame loops is made once per call rather
+    than per sample.
+    */
+    template <typename Lanes, Interpolation Quality, bool Morph>
+    inline void renderLanes(VoiceLaneState& lanes, int beginLane, int endLane,
+                            const RenderContext& context,
+                            float* left, float* right, int numSamples) noexcept
+    {
+        constexpr int W = Lanes::kWidth;
+        const auto* table = context.table;
+        const auto& envelope = *context.envelope;
+        auto* accumulator = context.accumulator;
+        const int shift = 32 - context.table_order;
+        const auto frac_mask = Lanes::set1i((juce::int32) ((1u << shift) - 1));
+        const auto frac_scale = Lanes::set1(1.0f / (float) (1u << shift));
+        const auto zero = Lanes::set1(0.0f);
+        const auto* next_table = table + context.frame_stride;
+
+        for (int start = 0; start < numSamples; start += kChunkSize)
+        {
+            const int num = juce::jmin(kChunkSize, numSamples - start);
+
+            for (int idx = 0; idx < 2 * num * W; idx += W)
+                Lanes::store(accumulator + idx, zero);
+
+            for (int lane = beginLane; lane < endLane; lane += W)
+            {
+                auto phase = Lanes::loadi((const juce::int32*) (lanes.phase + lane));
+                const auto increment = Lanes::loadi((const juce::int32*) (lanes.increment + lane));
+                const auto gain_left = Lanes::load(lanes.gain_left + lane);
+                const auto gain_right = Lanes::load(lanes.gain_right + lane);
+                const auto offset = Lanes::loadi(lanes.table_offset + lane);
+                const auto frame_mix = Lanes::load(lanes.frame_mix + lane);
+
+                int idx = 0;
+                while (idx < num)
+                {
+                    int run = num - idx;
+                    for (int l = lane; l < lane + W; ++l)
+                        run = juce::jmin(run, (int) lanes.env_samples_left[l]);
+
+                    auto level = Lanes::load(lanes.env_level + lane);
+                    const auto multiplier = Lanes::load(lanes.env_multiplier + lane);
+                    const auto env_offset = Lanes::load(lanes.env_offset + lane);
+
+                    for (const int end = idx + run; idx < end; ++idx)
+                    {
+                        auto index = Lanes::addi(Lanes::srl(phase, shift), offset);
+                        auto frac = Lanes::mul(Lanes::toFloat(Lanes::andi(phase, frac_mask)), frac_scale);
+                        auto sample = Interpolator<Quality>::template read<Lanes>(table, index, frac);
+
+                        if constexpr (Morph)
+                        {
+                            auto next = Interpolator<Quality>::template read<Lanes>(next_table, index, frac);
+                            sample = Lanes::fmadd(frame_mix, Lanes::sub(next, sample), sample);
+                        }
+
+                        level = Lanes::fmadd(level, multiplier, env_offset);
+                        const auto voice = Lanes::mul(sample, level);
+
+                        auto* acc = accumulator + 2 * idx * W;
+                        Lanes::store(acc, Lanes::fmadd(voice, gain_left, Lanes::load(acc)));
+                        Lanes::store(acc + W, Lanes::fmadd(voice, gain_right, Lanes::load(acc + W)));
+
+                        phase = Lanes::addi(phase, increment); // wraps by overflow
+                    }
+
+                    Lanes::store(lanes.env_level + lane, level);
+
+                    for (int l = lane; l < lane + W; ++l)
+                    {
+                        auto& left = lanes.env_samples_left[l];
+                        if (left != ADSREnvelope::kForever && (left -= run) == 0)
+                            lanes.finishStage(envelope, l);
+                    }
+                }
+
+                Lanes::storei((juce::int32*) (lanes.phase + lane), phase);
+            }
+
+            for (int idx = 0; idx < num; ++idx)
+            {
+                left[start + idx] += Lanes::sum(Lanes::load(accumulator + 2 * idx * W));
+                right[start + idx] += Lanes::sum(Lanes::load(accumulator + 2 * idx * W + W));
+            }
+        }
+    }
+
+    template <typename Lanes, Interpolation Quality>
+    inline void renderLanes(VoiceLaneState& lanes, int beginLane, int endLane,
+                            const RenderContext& context,
+                            float* left, float* right, int numSamples) noexcept
+    {
+        if (context.morph)
+            renderLanes<Lanes, Quality, true>(lanes, beginLane, endLane, context, left, right, numSamples);
+        else
+            renderLanes<Lanes, Quality, false>(lanes, beginLane, endLane, context, left, right, numSamples);
+    }
+
+    template <Interpolation Quality>
+    SIMD_KERNEL_DEFAULT
+    inline void renderScalar(VoiceLaneState& lanes, int beginLane, int endLane, const RenderContext& context,
+                             float* left, float* right, int numSamples) noexcept
+    {
+        renderLanes<LanesScalar, Quality>(lanes, beginLane, endLane, context, left, right, numSamples);
+    }
+
+   #if JUCE_INTEL
+    template <Interpolation Quality>
+    SIMD_KERNEL_DEFAULT
+    inline void renderSSE2(VoiceLaneState& lanes, int beginLane, int endLane, const RenderContext& context,
+                           float* left, float* right, int numSamples) noexcept
+    {
+        renderLanes<LanesSSE2, Quality>(lanes, beginLane, endLane, context, left, right, numSamples);
+    }
+
+    template <Interpolation Quality>
+    SIMD_KERNEL_AVX2
+    inline void renderAVX2(VoiceLaneState& lanes, int beginLane, int endLane, const RenderContext& context,
+                           float* left, float* right, int numSamples) noexcept
+    {
+        renderLanes<LanesAVX2, Quality>(lanes, beginLane, endLane, context, left, right, numSamples);
+    }
+
+    template <Interpolation Quality>
+    SIMD_KERNEL_AVX512
+    inline void renderAVX512(VoiceLaneState& lanes, int beginLane, int endLane, const RenderContext& context,
+                             float* left, float* right, int numSamples) noexcept
+    {
+        renderLanes<LanesAVX512, Quality>(lanes, beginLane, endLane, context, left, right, numSamples);
+    }
+   #endif
+
+    template <Interpolation Quality>
+    inline RenderFunction getRenderFunction(SimdLevel level, int& width) noexcept
+    {
+        switch (level)
+        {
+           #if JUCE_INTEL
+            case SimdLevel::avx512: width = 16; return renderAVX512<Quality>;
+            case SimdLevel::avx2:   width = 8;  return renderAVX2<Quality>;
+            case SimdLevel::sse2:   width = 4;  return renderSSE2<Quality>;
+           #endif
+            default:                width = 1;  return renderScalar<Quality>;
+        }
+    }
+
+    /** The kernel for an instruction set and interpolation tier, and its lane width. */
+    inline RenderFunction getRenderFunction(SimdLevel level, Interpolation quality, int& width) noexcept
+    {
+        switch (quality)
+        {
+            case Interpolation::truncate: return getRenderFunction<Interpolation::truncate>(level, width);
+            case Interpolation::hermite:  return getRenderFunction<Interpolation::hermite>(level, width);
+            case Interpolation::lagrange: return getRenderFunction<Interpolation::lagrange>(level, width);
+            default:                      return getRenderFunction<Interpolation::linear>(level, width);
+        }
+    }
+}
+
+//==============================================================================
+/**
+How VoiceBank picks a voice for a new note once every allowed voice is busy.
+*/
+enum class VoiceStealPolicy
+{
+    oldest,   // the voice started longest ago, preferring ones already released
+    quietest, // the voice with the lowest current envelope level times amplitude, past its attack
+    sameNote  // retrigger a voice already playing the note, otherwise as oldest
+};
+
+//==============================================================================
+/**
+A fixed-capacity bank of wavetable voices rendered lane-parallel.
+
+All oscillator and envelope state lives in one VoiceLaneState, and every
+voice reads the same band-limited wavetable (at the mipmap level its pitch
+needs), so render cost grows with the number of sounding voices rather than
+with the number of voice objects. Nothing here allocates after construction;
+all methods except the constructor are meant for the audio thread.
+
+The number of sounding voices never exceeds the polyphony cap, so a block
+never costs more than rendering that many voices. Released voices are freed
+within kControlInterval samples of their envelope dropping below the release
+cull level.
+
+Per-note expression (MPE) is kept per MIDI channel: a pitch bend, pressure
+or timbre message only stores a target for its channel, so it costs the
+same however many voices are sounding. Every kControlInterval samples,
+render() smooths each voice towards its channel's targets and folds the
+result into the lane's phase step, gains and wavetable position, which the
+render loop reads like any other lane state. A bend therefore moves in
+steps of under 3 ms at any buffer size.
+
+With a VoiceRenderPool attached, blocks with enough voices are split into
+groups of kLanesPerTask lanes rendered on the pool's workers, each into its
+own buffer; the buffers are then summed in group order, so the output does
+not depend on which thread rendered which group.
+*/
+class VoiceBank
+{
+public:
+    static constexpr int kMaxVoices = VoiceLaneState::kMaxLanes;
+    static constexpr int kTableSize = 4096;
+    static constexpr int kNumChannels = 16;
+
+    static constexpr int kLanesPerTask = 32; // a multiple of every register width
+    static constexpr int kMaxTasks = kMaxVoices / kLanesPerTask;
+    static constexpr int kParallelBlockSize = 256;
+    static constexpr int kDefaultParallelThreshold = 64;
+    static constexpr int kControlInterval = 128; // samples between the points where finished voices are freed and expression steps
+    static constexpr int kSpreadCentreNote = 64; // notes above go right of centre in the spread
+    static constexpr int kMaxUnison = 16;
+    static constexpr float kMaxUnisonDetune = 100.0f; // cents either side
+    static constexpr juce::uint32 kUnisonPhaseStep = 0x9e3779b9; // 2^32 / golden ratio, so no two copies start in phase
+    static constexpr float kTableStepsPerPhase = (float) (kTableSize / NoteFrequencyTable::kPhaseScale);
+    static constexpr int kMasterChannel = 1; // MPE lower zone: its bend moves every note
+    static constexpr float kDefaultMasterBendRange = 2.0f; // semitones
+    static constexpr float kDefaultNoteBendRange = 48.0f; // semitones, the MPE default
+    static constexpr float kMaxBendRange = 96.0f; // semitones
+    static constexpr float kPressureBoost = 1.0f; // full pressure doubles a voice's level
+    static constexpr double kExpressionSmoothingSeconds = 0.01;
+    static constexpr float kExpressionSnap = 1.0e-4f; // close enough to the target to stop smoothing
+    static constexpr double kMaxIncrement = 2147483647.0; // half a cycle per sample: Nyquist
+
+    explicit VoiceBank(Waveform waveform = Waveform::sine)
+        : wavetable_(WavetableCache::getInstance().get(waveform, kTableSize)),
+          render_(VoiceBankKernels::getRenderFunction(simd_level_, interpolation_, width_))
+    {
+        setSampleRate(sample_rate_);
+
+        for (int lane = 0; lane < kMaxVoices; ++lane)
+            clearLane(lane);
+    }
+
+    void setSampleRate(double sampleRate) noexcept
+    {
+        sample_rate_ = sampleRate;
+        modulation_amount_ = 1.0f - (float) std::exp(-(double) kControlInterval
+                                                     / (kExpressionSmoothingSeconds * sampleRate));
+        note_table_.prepare(sampleRate);
+        updateEnvelope();
+        allNotesOff();
+    }
+
+    /**
+    Recomputes the envelope coefficients. Sustaining voices glide to the new
+    sustain level; the others pick the new shape up at their next stage
+    change. Costs two exp calls plus a pass over the sounding voices, so call
+    it when the parameters change rather than every block.
+    */
+    void setEnvelope(const ADSREnvelope::Parameters& params) noexcept
+    {
+        envelope_params_ = params;
+        updateEnvelope();
+
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            if (lanes_.env_stage[lane] == ADSREnvelope::sustain)
+                lanes_.enterStage(envelope_, lane, ADSREnvelope::sustain);
+        }
+    }
+
+    /**
+    Releasing voices are freed once their envelope falls below this gain.
+    Raising it (to -60 dB, say) frees long release tails sooner; it takes
+    effect for notes released from now on.
+    */
+    void setReleaseCullLevel(float gain) noexcept
+    {
+        if (gain == release_cull_level_)
+            return;
+
+        release_cull_level_ = gain;
+        updateEnvelope();
+    }
+
+    /**
+    Caps the number of voices that can sound at once (1 to kMaxVoices). If
+    more than that are sounding now, the ones the steal policy would pick
+    are cut straight away.
+    */
+    void setMaxVoices(int maxVoices) noexcept
+    {
+        max_voices_ = juce::jlimit(1, kMaxVoices, maxVoices);
+
+        while (num_active_ > max_voices_)
+            removeVoice(chooseVoiceToSteal());
+    }
+
+    void setStealPolicy(VoiceStealPolicy policy) noexcept { steal_policy_ = policy; }
+
+    /**
+    Makes every new note a stack of copies (1 to kMaxUnison) detuned evenly
+    between -detuneCents and +detuneCents, each with its own start phase and
+    place in the stereo spread, at 1/sqrt(copies) the level so the stack is
+    about as loud as one copy. Sounding notes keep the stack they started
+    with. The detune ratios are only recomputed when the settings change.
+    */
+    void setUnison(int copies, float detuneCents) noexcept
+    {
+        copies = juce::jlimit(1, kMaxUnison, copies);
+        detuneCents = juce::jlimit(0.0f, kMaxUnisonDetune, detuneCents);
+
+        if (copies == unison_ && detuneCents == unison_detune_)
+            return;
+
+        unison_ = copies;
+        unison_detune_ = detuneCents;
+        unison_gain_ = 1.0f / std::sqrt((float) copies);
+
+        for (int copy = 0; copy < copies; ++copy)
+        {
+            const auto position = copies > 1 ? 2.0f * (float) copy / (float) (copies - 1) - 1.0f : 0.0f;
+            unison_ratio_[copy] = std::exp2((double) (position * detuneCents) / 1200.0);
+            unison_spread_[copy] = position;
+        }
+    }
+
+    int getUnisonCopies() const noexcept { return unison_; }
+    float getUnisonDetune() const noexcept { return unison_detune_; }
+
+    /**
+    Switches every voice, sounding ones included, to another table of
+    kTableSize samples; each keeps its phase and mip level. The old table is
+    only released here, so it must still be held elsewhere (WavetableCache
+    holds every table it hands out) for nothing to be freed on the audio
+    thread.
+    */
+    void setWavetable(SharedWavetable::Ptr table) noexcept
+    {
+        jassert(table != nullptr && table->getSize() == kTableSize);
+        wavetable_ = std::move(table);
+
+        for (int lane = 0; lane < num_active_; ++lane)
+            updateOscillator(lane);
+    }
+
+    /**
+    Where in a multi-frame table every voice plays, from 0 (the first frame)
+    to 1 (the last), before each voice's timbre moves it. Between two frames,
+    voices crossfade between them with a weight fixed until the next call,
+    so call it once per block with the modulated position. A change costs a
+    pass over the sounding voices; nothing is rebuilt.
+    */
+    void setFramePosition(float position) noexcept
+    {
+        position = juce::jlimit(0.0f, 1.0f, position);
+
+        if (position == frame_position_)
+            return;
+
+        frame_position_ = position;
+
+        for (int lane = 0; lane < num_active_; ++lane)
+            updateOscillator(lane);
+    }
+
+    float getFramePosition() const noexcept { return frame_position_; }
+
+    /**
+    How far apart in the stereo field voices are spread, from 0 (every voice
+    at its channel's pan) to 1 (the full width). Each voice has a fixed
+    place in the spread; today that follows its pitch, low notes to the
+    left and high notes to the right. The lane gains are only recomputed
+    when the spread changes, so this is cheap to call once per block.
+    */
+    void setStereoSpread(float spread) noexcept
+    {
+        spread = juce::jlimit(0.0f, 1.0f, spread);
+
+        if (spread == stereo_spread_)
+            return;
+
+        stereo_spread_ = spread;
+
+        for (int lane = 0; lane < num_active_; ++lane)
+            updatePan(lane);
+    }
+
+    float getStereoSpread() const noexcept { return stereo_spread_; }
+
+    /** Pans every voice on a MIDI channel, sounding ones included; -1 is hard left. */
+    void setChannelPan(int channel, float pan) noexcept
+    {
+        if (! juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            return;
+
+        channel_pan_[channel - 1] = juce::jlimit(-1.0f, 1.0f, pan);
+
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            if (voices_[lane].channel == channel)
+                updatePan(lane);
+        }
+    }
+
+    //==========================================================================
+    // Per-note expression
+
+    /**
+    Sets the pitch bend of a channel, from -1 to 1 of its bend range. In MPE
+    every note has a channel of its own, so this bends that note; the bend
+    of kMasterChannel applies to the notes on every channel, on top of their
+    own. O(1): the voices follow from the next control point (see render()).
+    */
+    void setPitchBend(int channel, float bend) noexcept
+    {
+        if (juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            channel_bend_[channel - 1] = juce::jlimit(-1.0f, 1.0f, bend);
+    }
+
+    /**
+    The bend ranges in semitones: of kMasterChannel, and of every other
+    channel. A bend already held is rescaled to the new range.
+    */
+    void setPitchBendRanges(float masterSemitones, float noteSemitones) noexcept
+    {
+        master_bend_range_ = juce::jlimit(0.0f, kMaxBendRange, masterSemitones);
+        note_bend_range_ = juce::jlimit(0.0f, kMaxBendRange, noteSemitones);
+    }
+
+    float getMasterBendRange() const noexcept { return master_bend_range_; }
+    float getNoteBendRange() const noexcept { return note_bend_range_; }
+
+    /**
+    Sets the pressure (channel aftertouch) of a channel, from 0 to 1. Voices
+    on it get louder by up to kPressureBoost times their level. O(1).
+    */
+    void setPressure(int channel, float pressure) noexcept
+    {
+        if (juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            channel_pressure_[channel - 1] = juce::jlimit(0.0f, 1.0f, pressure);
+    }
+
+    /**
+    Sets the timbre (MPE's CC 74) of a channel, from -1 to 1. It moves the
+    channel's voices through the wavetable frames from the shared frame
+    position: 1 reaches the last frame from anywhere, -1 the first. O(1).
+    */
+    void setTimbre(int channel, float timbre) noexcept
+    {
+        if (juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            channel_timbre_[channel - 1] = juce::jlimit(-1.0f, 1.0f, timbre);
+    }
+
+    const SharedWavetable::Ptr& getWavetable() const noexcept { return wavetable_; }
+
+    /**
+    Picks the interpolation tier every voice is read with. Each tier has its
+    own compiled kernel, so this swaps a function pointer and the per-sample
+    loop never branches on it.
+    */
+    void setInterpolation(Interpolation quality) noexcept
+    {
+        if (quality == interpolation_)
+            return;
+
+        interpolation_ = quality;
+        render_ = VoiceBankKernels::getRenderFunction(simd_level_, interpolation_, width_);
+    }
+
+    /**
+    Lets render() share the voices out over pool's workers whenever at least
+    threshold voices are sounding; below that the calling thread renders
+    alone, as handing out the work would cost more than it saves. Pass
+    nullptr to always render on the calling thread. Don't call this while
+    another thread may be inside render().
+    */
+    void setRenderPool(VoiceRenderPool* pool, int threshold = kDefaultParallelThreshold) noexcept
+    {
+        pool_ = pool;
+        parallel_threshold_ = juce::jmax(1, threshold);
+    }
+
+    int getMaxVoices() const noexcept { return max_voices_; }
+    VoiceStealPolicy getStealPolicy() const noexcept { return steal_policy_; }
+    Interpolation getInterpolation() const noexcept { return interpolation_; }
+    /** Sounding lanes; every unison copy counts as one. */
+    int getNumActiveVoices() const noexcept { return num_active_; }
+
+    //==========================================================================
+    /**
+    Starts a note at the pitch of a MIDI note; the phase step is a table
+    lookup. The note's unison copies go into adjacent lanes that share the
+    envelope, amplitude and mip level, so a 16-copy stack costs two AVX2
+    registers' worth of work (one with AVX-512) rather than 16 voices.
+    Whole notes are stolen to make room, never single copies.
+    */
+    void noteOn(int channel, int note, float amplitude) noexcept
+    {
+        if (steal_policy_ == VoiceStealPolicy::sameNote)
+        {
+            const int lane = findVoice(channel, note);
+
+            if (lane >= 0)
+            {
+                retriggerVoice(lane, amplitude);
+                return;
+            }
+        }
+
+        const int copies = juce::jmin(unison_, max_voices_);
+
+        while (num_active_ + copies > max_voices_)
+            removeVoice(chooseVoiceToSteal());
+
+        if (num_active_ == 0)
+            samples_since_control_ = 0;
+
+        const auto age = ++note_counter_;
+        const auto increment = note_table_.getIncrement(note);
+        const int index = juce::jlimit(0, kNumChannels - 1, channel - 1);
+
+        for (int copy = 0; copy < copies; ++copy)
+        {
+            const int lane = num_active_++;
+            auto& voice = voices_[lane];
+
+            // The note starts at its channel's expression rather than gliding there
+            voice = { channel, note, age, false, false, copies > 1 ? unison_spread_[copy] : getKeySpread(note) };
+            voice.base_increment = (juce::uint32) (juce::int64) std::llround((double) increment * unison_ratio_[copy]);
+            voice.bend = getBendTarget(channel);
+            voice.pressure = channel_pressure_[index];
+            voice.timbre = channel_timbre_[index];
+
+            lanes_.phase[lane] = (juce::uint32) copy * kUnisonPhaseStep;
+            updateOscillator(lane);
+            startLane(lane, amplitude * unison_gain_);
+        }
+    }
+
+    /**
+    Moves every held voice playing this note into its release stage, or
+    marks it to be released with the sustain pedal if the pedal is down.
+    */
+    void noteOff(int channel, int note) noexcept
+    {
+        const bool pedal = isSustainPedalDown(channel);
+
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            auto& voice = voices_[lane];
+            if (voice.note == note && voice.channel == channel && ! voice.released)
+            {
+                if (pedal)
+                    voice.pedal_held = true;
+                else
+                    releaseVoice(lane);
+            }
+        }
+    }
+
+    /** Releasing the pedal releases every note that was let go while it was down. */
+    void setSustainPedal(int channel, bool isDown) noexcept
+    {
+        if (! juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            return;
+
+        sustain_pedal_[channel - 1] = isDown;
+
+        if (isDown)
+            return;
+
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            const auto& voice = voices_[lane];
+            if (voice.channel == channel && voice.pedal_held && ! voice.released)
+                releaseVoice(lane);
+        }
+    }
+
+    /** Silences everything immediately. */
+    void allNotesOff() noexcept
+    {
+        for (int lane = 0; lane < num_active_; ++lane)
+            clearLane(lane);
+
+        num_active_ = 0;
+    }
+
+    //==========================================================================
+    /**
+    Adds numSamples samples of every sounding voice into left and right,
+    freeing the voices whose envelopes have finished (released notes that
+    have rung out, and held notes at an inaudible sustain level) along the
+    way. A bank with no voices returns straight away.
+
+    Every kControlInterval samples, counted from when the bank last started
+    from empty, finished voices are freed (the others keep their order) and
+    each voice's expression takes one smoothing step. Where the caller
+    splits its blocks therefore never changes which lane a voice renders
+    in, the order the lanes are summed in or when a bend moves, so the
+    output is the same sample for sample, as long as expression targets are
+    set before the control point they should reach (see
+    getSamplesToNextControlPoint()).
+    */
+    void render(float* left, float* right, int numSamples) noexcept
+    {
+        while (numSamples > 0 && num_active_ > 0)
+        {
+            const int num = juce::jmin(numSamples, kControlInterval - samples_since_control_);
+            renderActive(left, right, num);
+
+            left += num;
+            right += num;
+            numSamples -= num;
+            samples_since_control_ += num;
+
+            if (samples_since_control_ == kControlInterval)
+            {
+                samples_since_control_ = 0;
+                cullFinishedVoices();
+                updateModulation();
+            }
+        }
+    }
+
+    /**
+    Samples left before render() next frees voices and steps expression. A
+    caller that sets an expression target for a later sample should render
+    up to it first if this many samples or fewer lie in between.
+    */
+    int getSamplesToNextControlPoint() const noexcept { return kControlInterval - samples_since_control_; }
+
+private:
+    void renderActive(float* left, float* right, int numSamples) noexcept
+    {
+        const int num_lanes = (num_active_ + width_ - 1) / width_ * width_;
+
+        morph_ = false;
+        for (int lane = 0; lane < num_active_ && ! morph_; ++lane)
+            morph_ = lanes_.frame_mix[lane] != 0.0f;
+
+        if (pool_ != nullptr && num_active_ >= parallel_threshold_ && num_lanes > kLanesPerTask)
+        {
+            renderParallel(num_lanes, left, right, numSamples);
+        }
+        else
+        {
+            render_(lanes_, 0, num_lanes, makeContext(accumulator_), left, right, numSamples);
+        }
+    }
+
+    /**
+    Moves every voice's bend, pressure and timbre one control interval's
+    worth of a one-pole smoother towards its channel's targets, then
+    refreshes the lanes of the voices that moved. The cost is a pass over
+    the voices, however many expression messages arrived.
+    */
+    void updateModulation() noexcept
+    {
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            auto& voice = voices_[lane];
+            const int index = juce::jlimit(0, kNumChannels - 1, voice.channel - 1);
+            const auto bend_moved = smooth(voice.bend, getBendTarget(voice.channel), modulation_amount_);
+            const auto timbre_moved = smooth(voice.timbre, channel_timbre_[index], modulation_amount_);
+
+            if (bend_moved || timbre_moved)
+                updateOscillator(lane);
+
+            if (smooth(voice.pressure, channel_pressure_[index], modulation_amount_))
+                updatePan(lane);
+        }
+    }
+
+    /** Frees every voice whose envelope has finished, keeping the rest in order. */
+    void cullFinishedVoices() noexcept
+    {
+        int kept = 0;
+
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            if (lanes_.env_stage[lane] == ADSREnvelope::idle)
+                continue;
+
+            if (kept != lane)
+            {
+                voices_[kept] = voices_[lane];
+                lanes_.copyLane(kept, lane);
+            }
+
+            ++kept;
+        }
+
+        for (int lane = kept; lane < num_active_; ++lane)
+            clearLane(lane);
+
+        num_active_ = kept;
+    }
+
+    struct VoiceInfo
+    {
+        int channel = 0;
+        int note = -1;
+        juce::uint32 age = 0; // shared by the unison copies of one note
+        bool released = false;
+        bool pedal_held = false; // note off arrived while the sustain pedal was down
+        float spread = 0.0f; // place in the stereo spread, -1 to 1
+
+        // Per-note expression, smoothed towards the channel's targets
+        juce::uint32 base_increment = 0; // phase step before the bend, unison detune included
+        float bend = 0.0f; // semitones
+        float pressure = 0.0f;
+        float timbre = 0.0f;
+    };
+
+    /** Moves value amount of the way to target; false if it was already there. */
+    static bool smooth(float& value, float target, float amount) noexcept
+    {
+        if (value == target)
+            return false;
+
+        value += amount * (target - value);
+
+        if (std::abs(target - value) < kExpressionSnap)
+            value = target;
+
+        return true;
+    }
+
+    /** A voice's bend in semitones: its channel's, plus the master channel's. */
+    float getBendTarget(int channel) const noexcept
+    {
+        if (! juce::isPositiveAndBelow(channel - 1, kNumChannels))
+            return 0.0f;
+
+        const auto master = channel_bend_[kMasterChannel - 1] * master_bend_range_;
+        return channel == kMasterChannel ? master : channel_bend_[channel - 1] * note_bend_range_ + master;
+    }
+
+    /**
+    Sets a lane's phase step from its note, detune and bend, and its mip
+    level, frame and frame weight from that step, the shared frame position
+    and its timbre. A voice without a bend keeps its exact unbent step; a
+    bent one takes its step from the note table, so a bend costs two loads
+    and a divide rather than an exp2(). The mip level follows the note
+    rather than the detuned copy, so every copy of a unison stack reads the
+    same level.
+    */
+    void updateOscillator(int lane) noexcept
+    {
+        const auto& voice = voices_[lane];
+        auto increment = voice.base_increment;
+        auto note_increment = (double) note_table_.getIncrement(voice.note);
+
+        if (voice.bend != 0.0f)
+        {
+            const auto bent = juce::jmin(kMaxIncrement, (double) note_table_.getIncrement(voice.note, voice.bend));
+            increment = (juce::uint32) (juce::int64) std::llround(juce::jmin(kMaxIncrement,
+                                                                             (double) increment * bent / note_increment));
+            note_increment = bent;
+        }
+
+        const int last = wavetable_->getNumFrames() - 1;
+        const auto scaled = juce::jlimit(0.0f, 1.0f, frame_position_ + voice.timbre) * (float) last;
+        const int frame = juce::jmin((int) scaled, last);
+
+        lanes_.increment[lane] = increment;
+        lanes_.table_offset[lane] = wavetable_->getOffset(
+            wavetable_->getLevelForIncrement((float) note_increment * kTableStepsPerPhase), frame);
+        lanes_.frame_mix[lane] = frame < last ? scaled - (float) frame : 0.0f;
+    }
+
+    void updateEnvelope() noexcept
+    {
+        envelope_.compute(envelope_params_, sample_rate_, release_cull_level_);
+    }
+
+    /** Sets a lane's level and starts its attack; the oscillator is already set up. */
+    void startLane(int lane, float amplitude) noexcept
+    {
+        lanes_.amplitude[lane] = amplitude;
+        updatePan(lane);
+        lanes_.enterStage(envelope_, lane, ADSREnvelope::attack);
+    }
+
+    /**
+    Restarts the attack of every copy of the note in lane, from the current
+    level and keeping the phases, so the retrigger doesn't click.
+    */
+    void retriggerVoice(int lane, float amplitude) noexcept
+    {
+        const auto age = voices_[lane].age;
+        int copies = 0;
+
+        for (int other = 0; other < num_active_; ++other)
+            copies += voices_[other].age == age ? 1 : 0;
+
+        const auto new_age = ++note_counter_;
+        const auto gain = 1.0f / std::sqrt((float) copies);
+
+        for (int other = 0; other < num_active_; ++other)
+        {
+            auto& voice = voices_[other];
+            if (voice.age != age)
+                continue;
+
+            voice.age = new_age;
+            voice.released = false;
+            voice.pedal_held = false;
+            startLane(other, amplitude * gain);
+        }
+    }
+
+    /** Without unison, a note's place in the stereo spread follows its pitch. */
+    static float getKeySpread(int note) noexcept
+    {
+        return juce::jlimit(-1.0f, 1.0f, (float) (note - kSpreadCentreNote) / (float) kSpreadCentreNote);
+    }
+
+    /** Folds the voice's pressure, channel pan and place in the spread into its lane gains. */
+    void updatePan(int lane) noexcept
+    {
+        const auto& voice = voices_[lane];
+        float left, right;
+        StereoPan::getGains(getChannelPan(voice.channel) + stereo_spread_ * voice.spread, left, right);
+
+        const auto level = lanes_.amplitude[lane] * (1.0f + kPressureBoost * voice.pressure);
+        lanes_.gain_left[lane] = level * left;
+        lanes_.gain_right[lane] = level * right;
+    }
+
+    void releaseVoice(int lane) noexcept
+    {
+        voices_[lane].released = true;
+        lanes_.enterStage(envelope_, lane, ADSREnvelope::release);
+    }
+
+    bool isSustainPedalDown(int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow(channel - 1, kNumChannels) && sustain_pedal_[channel - 1];
+    }
+
+    float getChannelPan(int channel) const noexcept
+    {
+        return juce::isPositiveAndBelow(channel - 1, kNumChannels) ? channel_pan_[channel - 1] : 0.0f;
+    }
+
+    /** The sounding voice playing this note, or -1. */
+    int findVoice(int channel, int note) const noexcept
+    {
+        for (int lane = 0; lane < num_active_; ++lane)
+        {
+            if (voices_[lane].note == note && voices_[lane].channel == channel)
+                return lane;
+        }
+
+        return -1;
+    }
+
+    /** The voice to cut for a new one under the current policy. O(voices). */
+    int chooseVoiceToSteal() const noexcept
+    {
+        int victim = 0;
+
+        for (int lane = 1; lane < num_active_; ++lane)
+        {
+            if (steal_policy_ == VoiceStealPolicy::quietest)
+            {
+                if (isQuieterVictim(lane, victim))
+                    victim = lane;
+            }
+            else
+            {
+                const auto& voice = voices_[lane];
+                const auto& best = voices_[victim];
+
+                if (voice.released != best.released ? voice.released : voice.age < best.age)
+                    victim = lane;
+            }
+        }
+
+        return victim;
+    }
+
+    /**
+    For the quietest policy: whether lane is a better voice to steal than
+    victim. Released voices go first, as with the oldest policy. A voice
+    still in its attack only goes after every other, oldest first: it has
+    barely started, so its low level says nothing, and several note-ons on
+    one sample would otherwise each steal the one before. Equal levels go to
+    the older voice.
+    */
+    bool isQuieterVictim(int lane, int victim) const noexcept
+    {
+        const auto& voice = voices_[lane];
+        const auto& best = voices_[victim];
+
+        if (voice.released != best.released)
+            return voice.released;
+
+        const bool attacking = lanes_.env_stage[lane] == ADSREnvelope::attack;
+        const bool best_attacking = lanes_.env_stage[victim] == ADSREnvelope::attack;
+
+        if (attacking != best_attacking)
+            return best_attacking;
+
+        const auto level = lanes_.env_level[lane] * lanes_.amplitude[lane];
+        const auto best_level = lanes_.env_level[victim] * lanes_.amplitude[victim];
+
+        if (attacking || level == best_level)
+            return voice.age < best.age;
+
+        return level < best_level;
+    }
+
+    void renderParallel(int numLanes, float* left, float* right, int numSamples) noexcept
+    {
+        const int num_tasks = (numLanes + kLanesPerTask - 1) / kLanesPerTask;
+        parallel_lanes_ = numLanes;
+
+        for (int start = 0; start < numSamples; start += kParallelBlockSize)
+        {
+            parallel_samples_ = juce::jmin(kParallelBlockSize, numSamples - start);
+            pool_->run(renderTask, this, num_tasks);
+
+            // Fixed-order reduction
+            for (int task = 0; task < num_tasks; ++task)
+            {
+                juce::FloatVectorOperations::add(left + start, task_outputs_[task][0], parallel_samples_);
+                juce::FloatVectorOperations::add(right + start, task_outputs_[task][1], parallel_samples_);
+            }
+        }
+    }
+
+    /** One group of lanes, on whichever thread claimed it. */
+    static void renderTask(void* context, int task) noexcept
+    {
+        auto& bank = *static_cast<VoiceBank*>(context);
+        const int begin = task * kLanesPerTask;
+        const int end = juce::jmin(begin + kLanesPerTask, bank.parallel_lanes_);
+        auto* left = bank.task_outputs_[task][0];
+        auto* right = bank.task_outputs_[task][1];
+
+        juce::FloatVectorOperations::clear(left, bank.parallel_samples_);
+        juce::FloatVectorOperations::clear(right, bank.parallel_samples_);
+        bank.render_(bank.lanes_, begin, end, bank.makeContext(bank.task_accumulators_[task]),
+                     left, right, bank.parallel_samples_);
+    }
+
+    VoiceBankKernels::RenderContext makeContext(float* accumulator) const noexcept
+    {
+        return { wavetable_->getReadPointer(), table_order_, wavetable_->getFrameStride(),
+                 morph_, &envelope_, accumulator };
+    }
+
+    /** Cuts the note in lane along with all its other unison copies. */
+    void removeVoice(int lane) noexcept
+    {
+        const auto age = voices_[lane].age;
+
+        // Downwards, so whatever removeLane() moves into a gap has already been checked
+        for (int other = num_active_ - 1; other >= 0; --other)
+        {
+            if (voices_[other].age == age)
+                removeLane(other);
+        }
+    }
+
+    /** Keeps lanes packed by moving the last sounding voice into the gap. */
+    void removeLane(int lane) noexcept
+    {
+        const int last = --num_active_;
+
+        voices_[lane] = voices_[last];
+        lanes_.copyLane(lane, last);
+        clearLane(last);
+    }
+
+    void clearLane(int lane) noexcept
+    {
+        voices_[lane] = {};
+        lanes_.clearLane(lane);
+    }
+
+    VoiceLaneState lanes_;
+    VoiceInfo voices_[kMaxVoices];
+    alignas(64) float accumulator_[VoiceBankKernels::kAccumulatorSize];
+
+    SharedWavetable::Ptr wavetable_;
+    int table_order_ = wavetable_->getOrder();
+    float frame_position_ = 0.0f;
+    bool morph_ = false; // some sounding lane has a frame_mix
+    NoteFrequencyTable note_table_;
+    double sample_rate_ = 48000.0;
+    float modulation_amount_ = 0.0f; // one control interval of expression smoothing
+
+    ADSREnvelope::Parameters envelope_params_;
+    ADSREnvelope::Coefficients envelope_;
+    float release_cull_level_ = (float) ADSREnvelope::Coefficients::kReleaseFloor;
+
+    int num_active_ = 0;
+    int samples_since_control_ = 0;
+    int max_voices_ = kMaxVoices;
+    VoiceStealPolicy steal_policy_ = VoiceStealPolicy::oldest;
+    juce::uint32 note_counter_ = 0;
+    bool sustain_pedal_[kNumChannels] = {};
+    float channel_pan_[kNumChannels] = {};
+    float channel_bend_[kNumChannels] = {}; // -1 to 1 of the channel's range
+    float channel_pressure_[kNumChannels] = {};
+    float channel_timbre_[kNumChannels] = {};
+    float master_bend_range_ = kDefaultMasterBendRange;
+    float note_bend_range_ = kDefaultNoteBendRange;
+    float stereo_spread_ = 0.0f;
+
+    int unison_ = 1;
+    float unison_detune_ = 0.0f;
+    float unison_gain_ = 1.0f;
+    double unison_ratio_[kMaxUnison] = { 1.0 };
+    float unison_spread_[kMaxUnison] = {};
+
+    const SimdLevel simd_level_ = detectSimdLevel();
+    Interpolation interpolation_ = Interpolation::linear;
+    int width_ = 1;
+    VoiceBankKernels::RenderFunction render_;
+
+    VoiceRenderPool* pool_ = nullptr;
+    int parallel_threshold_ = kDefaultParallelThreshold;
+    int parallel_lanes_ = 0;
+    int parallel_samples_ = 0;
+    alignas(64) float task_accumulators_[kMaxTasks][VoiceBankKernels::kAccumulatorSize];
+    alignas(64) float task_outputs_[kMaxTasks][2][kParallelBlockSize];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceBank)
+};
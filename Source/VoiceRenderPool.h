@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.h
+    Created: 17 Oct 2026 8:51:16pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+A fixed set of real-time worker threads that help the audio thread through
+a batch of independent tasks.
+
+run() publishes a batch and then works on it too, so it always finishes
+even if no worker wakes in time. Tasks are claimed with a compare-and-swap
+on one 64-bit word holding the batch number, the task count and the next
+task index, so a worker that is late for one batch can never claim a task
+from the next. Which thread ran which task is not fixed; callers that need
+repeatable output should give every task its own output and combine them in
+task order afterwards.
+
+Workers spin for a short while after each batch, then keep polling with a
+yield in between for as long as batches keep coming (the next one usually
+comes one block later), so while audio is running run() never has to wake
+anyone. Only after kAwakeTimeoutMs without a batch, e.g. once the device
+stops or the voice count drops below the bank's threshold, do they sleep on
+an event; the first batch after that signals it. Nothing here allocates or
+locks on the audio thread apart from that one signal.
+*/
+class VoiceRenderPool
+{
+public:
+    using Task = void (*)(void* context, int taskIndex);
+
+    static constexpr int kMaxTasks = 0xffff;
+
+    /**
+    Starts numWorkers threads at real-time priority, worker i pinned to
+    physical core i + 1 where there are enough cores and their layout is
+    known (the audio thread is left free to run anywhere). Pinning by core
+    rather than by logical CPU keeps two workers off the hardware threads of
+    one core.
+    */
+    explicit VoiceRenderPool(int numWorkers)
+    {
+        const auto cores = getFirstCpuOfEachCore();
+
+        for (int idx = 0; idx < numWorkers; ++idx)
+        {
+            auto* worker = workers_.emplace_back(std::make_unique<Worker>(*this, idx)).get();
+
+            if (idx + 1 < (int) cores.size() && cores[(size_t) idx + 1] < 32)
+                worker->setAffinityMask((juce::uint32) 1 << cores[(size_t) idx + 1]);
+
+            if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions().withPriority(kRealtimePriority)))
+                worker->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    ~VoiceRenderPool()
+    {
+        for (auto& worker : workers_)
+            worker->signalThreadShouldExit();
+
+        for (auto& worker : workers_)
+        {
+            worker->wake.signal();
+            worker->stopThread(kStopTimeoutMs);
+        }
+    }
+
+    int getNumWorkers() const noexcept { return (int) workers_.size(); }
+
+    /**
+    Runs task(context, i) for every i in [0, numTasks) across the workers and
+    the calling thread, and returns once all of them have finished. Call it
+    from one thread at a time.
+    */
+    void run(Task task, void* context, int numTasks) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(numTasks, kMaxTasks + 1));
+
+        if (numTasks <= 0)
+            return;
+
+        task_ = task;
+        context_ = context;
+        done_.store(0, std::memory_order_relaxed);
+
+        batch_ = (batch_ + 1) & 0xffffffff;
+        claim_.store(pack(batch_, numTasks, 0), std::memory_order_seq_cst);
+
+        for (auto& worker : workers_)
+        {
+            if (worker->sleeping.exchange(false, std::memory_order_seq_cst))
+                worker->wake.signal();
+        }
+
+        while (runOne())
+        {
+        }
+
+        while (done_.load(std::memory_order_acquire) < numTasks)
+            spinPause();
+    }
+
+private:
+    struct Worker  : public juce::Thread
+    {
+        Worker(VoiceRenderPool& owner, int index)
+            : juce::Thread("Voice render " + juce::String(index)), pool(owner)
+        {
+        }
+
+        void run() override
+        {
+            const juce::ScopedNoDenormals no_denormals; // the audio thread's flags don't carry over
+            pool.workerLoop(*this);
+        }
+
+        VoiceRenderPool& pool;
+        juce::WaitableEvent wake;
+        std::atomic<bool> sleeping { false };
+    };
+
+    static constexpr int kRealtimePriority = 8;
+    static constexpr int kSpinIterations = 20000;
+    static constexpr int kIdleTimeoutMs = 100;
+    static constexpr juce::uint32 kAwakeTimeoutMs = 250; // longer than any block, at any buffer size
+    static constexpr int kStopTimeoutMs = 1000;
+
+    static constexpr juce::uint64 pack(juce::uint64 batch, int numTasks, int next) noexcept
+    {
+        return (batch << 32) | ((juce::uint64) numTasks << 16) | (juce::uint64) next;
+    }
+
+    static forcedinline void spinPause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+       #endif
+    }
+
+    /** Claims and runs one task of the current batch; false once there are none left. */
+    bool runOne() noexcept
+    {
+        auto claim = claim_.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            const int num_tasks = (int) ((claim >> 16) & 0xffff);
+            const int next = (int) (claim & 0xffff);
+
+            if (next >= num_tasks)
+                return false;
+
+            if (claim_.compare_exchange_weak(claim, claim + 1,
+                                             std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                task_(context_, next);
+                done_.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    /**
+    One logical CPU per physical core, in core order. Linux reads the
+    layout from sysfs; Windows numbers a core's hardware threads next to each
+    other. Empty where it can't be told, which leaves the workers unpinned.
+    */
+    static std::vector<int> getFirstCpuOfEachCore()
+    {
+        std::vector<int> cpus;
+        const int num_cpus = juce::SystemStats::getNumCpus();
+
+       #if JUCE_LINUX
+        juce::StringArray cores;
+
+        for (int cpu = 0; cpu < num_cpus; ++cpu)
+        {
+            const auto topology = juce::File("/sys/devices/system/cpu/cpu" + juce::String(cpu) + "/topology");
+            const auto core_id = topology.getChildFile("core_id");
+
+            if (! core_id.existsAsFile())
+                return {};
+
+            // Core ids repeat across sockets, so the package is part of the key
+            if (cores.addIfNotAlreadyThere(topology.getChildFile("physical_package_id").loadFileAsString().trim()
+                                             + ":" + core_id.loadFileAsString().trim()))
+                cpus.push_back(cpu);
+        }
+       #elif JUCE_WINDOWS
+        const int num_cores = juce::SystemStats::getNumPhysicalCpus();
+
+        if (num_cores > 0 && num_cpus % num_cores == 0)
+            for (int core = 0; core < num_cores; ++core)
+                cpus.push_back(core * (num_cpus / num_cores));
+       #else
+        juce::ignoreUnused(num_cpus);
+       #endif
+
+        return cpus;
+    }
+
+    void workerLoop(Worker& worker)
+    {
+        auto seen = claim_.load(std::memory_order_acquire) >> 32;
+        auto last_batch_time = juce::Time::getMillisecondCounter();
+
+        while (! worker.threadShouldExit())
+        {
+            int spins = 0;
+            auto batch = claim_.load(std::memory_order_acquire) >> 32;
+
+            while (batch == seen && ++spins < kSpinIterations)
+            {
+                spinPause();
+                batch = claim_.load(std::memory_order_acquire) >> 32;
+            }
+
+            // Still within a block or two of the last batch: stay awake, giving
+            // the core away between polls, so run() has nobody to signal
+            while (batch == seen && juce::Time::getMillisecondCounter() - last_batch_time < kAwakeTimeoutMs
+                     && ! worker.threadShouldExit())
+            {
+                juce::Thread::yield();
+                batch = claim_.load(std::memory_order_acquire) >> 32;
+            }
+
+            if (batch == seen)
+            {
+                // Announce the sleep, then look once more so a batch published
+                // in between isn't missed
+                worker.sleeping.store(true, std::memory_order_seq_cst);
+
+                if ((claim_.load(std::memory_order_seq_cst) >> 32) == seen)
+                    worker.wake.wait(kIdleTimeoutMs);
+
+                worker.sleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+
+            seen = batch;
+            last_batch_time = juce::Time::getMillisecondCounter();
+
+            while (runOne())
+            {
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::atomic<juce::uint64> claim_ { 0 }; // batch << 32 | task count << 16 | next task
+    std::atomic<int> done_ { 0 };
+    Task task_ = nullptr;
+    void* context_ = nullptr;
+    juce::uint64 batch_ = 0; // caller's thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceRenderPool)
+};
@@ -0,0 +1,374 @@
+/*
+  ==============================================================================
+
+    WavetableCache.h
+    Created: 17 Oct 2026 3:21:16pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <complex>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+enum class Waveform
+{
+    sine,
+    saw,
+    square,
+    triangle
+};
+
+//==============================================================================
+/**
+One or more single-cycle frames of a waveform as sets of band-limited mipmap
+levels, built once and then only ever read.
+
+Level 0 keeps every harmonic the table can represent (size / 2); each level
+after that keeps half as many, so level k is alias-free for any phase
+increment up to 2^k table samples per output sample. Each frame of a level
+is getSize() samples wrapped in guard samples (one copy of the last sample
+before, copies of the first two after) so no interpolation tier ever has to
+wrap. All frames of one level are stored next to each other, then the next
+level, so a voice moving between neighbouring frames stays in the same few
+cache lines.
+
+Built-in tables have one frame computed from a Waveform; user tables are
+read from a file a frame at a time (see WavetableLoader). Voices keep a Ptr
+to it; the samples are never modified after construction, so any number of
+threads can read them.
+
+Every level of every frame is built in the constructor, as nothing may be
+built once the audio thread reads the table. A frame costs levels x
+getFrameStride() floats: about 200 KB at 4096 samples, so a 256-frame bank
+holds about 50 MB. Building a frame is an FFT per level, plus, for a cycle
+whose length isn't a power of two, a direct DFT of (size / 2) x length.
+*/
+class SharedWavetable  : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SharedWavetable>;
+
+    /** Fills cycle with one period of a frame; any length, ideally a power of two. */
+    using FrameReader = std::function<void(int frame, std::vector<float>& cycle)>;
+
+    static constexpr int kGuardSamplesBefore = 1;
+    static constexpr int kGuardSamplesAfter = 2;
+
+    SharedWavetable(Waveform waveform, int size)
+        : SharedWavetable(waveform, juce::File(), size, 1)
+    {
+        std::vector<float> cycle((size_t) size);
+        for (int i = 0; i < size; ++i)
+        {
+            cycle[(size_t) i] = evaluate(waveform, (double) i / (double) size);
+        }
+
+        buildFrame(0, cycle);
+    }
+
+    /**
+    A user table of numFrames frames read from source, one frame at a time,
+    so only one decoded frame is ever held besides the table itself.
+    */
+    SharedWavetable(const juce::File& source, int size, int numFrames, const FrameReader& readFrame)
+        : SharedWavetable(Waveform::sine, source, size, numFrames)
+    {
+        std::vector<float> cycle;
+
+        for (int frame = 0; frame < num_frames_; ++frame)
+        {
+            readFrame(frame, cycle);
+            buildFrame(frame, cycle.empty() ? std::vector<float>((size_t) size_, 0.0f) : cycle);
+        }
+    }
+
+    Waveform getWaveform() const noexcept { return waveform_; }
+    const juce::File& getSource() const noexcept { return source_; } // File() for built-in tables
+    int getSize() const noexcept { return size_; }
+    int getOrder() const noexcept { return order_; } // log2 of the size
+    int getNumLevels() const noexcept { return num_levels_; }
+    int getNumFrames() const noexcept { return num_frames_; }
+
+    /** Distance in samples between the start of two consecutive frames. */
+    int getFrameStride() const noexcept { return kGuardSamplesBefore + size_ + kGuardSamplesAfter; }
+
+    /** Distance in samples between the start of two consecutive levels. */
+    int getLevelStride() const noexcept { return num_frames_ * getFrameStride(); }
+
+    /** Where a frame of a level starts, relative to getReadPointer(). */
+    int getOffset(int level, int frame = 0) const noexcept
+    {
+        return level * getLevelStride() + frame * getFrameStride();
+    }
+
+    /** The first sample of a frame of a level; the guard samples sit either side of it. */
+    const float* getReadPointer(int level = 0, int frame = 0) const noexcept
+    {
+        jassert(juce::isPositiveAndBelow(level, num_levels_));
+        jassert(juce::isPositiveAndBelow(frame, num_frames_));
+        return samples_.data() + (size_t) (getOffset(level, frame) + kGuardSamplesBefore);
+    }
+
+    /**
+    The level to play with a phase increment of increment table samples per
+    output sample: the richest one whose top harmonic stays below Nyquist.
+    Call this when the pitch changes, not per sample.
+    */
+    int getLevelForIncrement(float increment) const noexcept
+    {
+        int level = 0;
+        while (level < num_levels_ - 1 && (float) (1 << level) < increment)
+            ++level;
+
+        return level;
+    }
+
+    /**
+    The value of one period of waveform at phase (0 to 1).
+    */
+    static float evaluate(Waveform waveform, double phase)
+    {
+        switch (waveform)
+        {
+            case Waveform::saw:      return (float) (2.0 * phase - 1.0);
+            case Waveform::square:   return phase < 0.5 ? 1.0f : -1.0f;
+            case Waveform::triangle: return (float) (1.0 - 4.0 * std::abs(phase - 0.5));
+            case Waveform::sine:
+            default:                 return (float) std::sin(juce::MathConstants<double>::twoPi * phase);
+        }
+    }
+
+private:
+    static int getOrder(int size) noexcept
+    {
+        int order = 0;
+        while ((1 << order) < size)
+            ++order;
+
+        return order;
+    }
+
+    SharedWavetable(Waveform waveform, const juce::File& source, int size, int numFrames)
+        : waveform_(waveform),
+          source_(source),
+          size_(size),
+          order_(getOrder(size)),
+          num_levels_(order_),
+          num_frames_(juce::jmax(1, numFrames))
+    {
+        jassert(juce::isPowerOfTwo(size) && size >= 2);
+        // One spare frame of silence at the end, so a voice crossfading from the
+        // last frame of the last level can read its (zero-weighted) next frame
+        samples_.assign((size_t) (num_levels_ * getLevelStride() + getFrameStride()), 0.0f);
+    }
+
+    /**
+    Takes the spectrum of cycle once, then for each level zeroes every bin
+    above that level's harmonic limit and transforms back into the frame.
+
+    A cycle of any length is moved into a size_-point spectrum harmonic by
+    harmonic, so a 2048-sample frame fills a 4096-sample table without any
+    interpolation error. Power-of-two lengths use the FFT; other lengths a
+    direct DFT of just the harmonics the table can hold.
+    */
+    void buildFrame(int frame, const std::vector<float>& cycle)
+    {
+        using Complex = std::complex<float>;
+
+        const int length = (int) cycle.size();
+        const int top = juce::jmin(length, size_) / 2;
+        std::vector<Complex> time((size_t) juce::jmax(length, size_)), spectrum((size_t) length);
+
+        if (juce::isPowerOfTwo(length))
+        {
+            for (int i = 0; i < length; ++i)
+                time[(size_t) i] = cycle[(size_t) i];
+
+            juce::dsp::FFT(getOrder(length)).perform(time.data(), spectrum.data(), false);
+        }
+        else
+        {
+            std::vector<std::complex<double>> twiddles((size_t) length);
+            for (int i = 0; i < length; ++i)
+                twiddles[(size_t) i] = std::polar(1.0, -juce::MathConstants<double>::twoPi * i / length);
+
+            for (int harmonic = 0; harmonic <= top; ++harmonic)
+            {
+                std::complex<double> sum;
+                for (int i = 0; i < length; ++i)
+                    sum += (double) cycle[(size_t) i] * twiddles[(size_t) ((juce::int64) harmonic * i % length)];
+
+                spectrum[(size_t) harmonic] = Complex((float) sum.real(), (float) sum.imag());
+                spectrum[(size_t) ((length - harmonic) % length)] = std::conj(spectrum[(size_t) harmonic]);
+            }
+        }
+
+        // Same harmonics, size_-point spectrum
+        std::vector<Complex> full((size_t) size_), bins((size_t) size_);
+        const auto scale = (float) size_ / (float) length;
+
+        for (int harmonic = 0; harmonic <= top; ++harmonic)
+        {
+            // The input's own Nyquist bin holds both halves of its cosine
+            const auto weight = (length % 2 == 0 && harmonic == length / 2 && length < size_) ? 0.5f * scale : scale;
+            full[(size_t) harmonic] = spectrum[(size_t) harmonic] * weight;
+
+            if (harmonic > 0)
+                full[(size_t) (size_ - harmonic)] = spectrum[(size_t) (length - harmonic)] * weight;
+        }
+
+        juce::dsp::FFT fft(order_);
+
+        for (int level = 0; level < num_levels_; ++level)
+        {
+            const int max_harmonic = (size_ / 2) >> level;
+
+            // Inverse via the forward transform, x = conj(FFT(conj(X))) / N,
+            // so the scaling doesn't depend on which FFT engine JUCE picked.
+            for (int bin = 0; bin < size_; ++bin)
+            {
+                const int harmonic = juce::jmin(bin, size_ - bin);
+                bins[(size_t) bin] = harmonic <= max_harmonic ? std::conj(full[(size_t) bin])
+                                                              : Complex();
+            }
+
+            fft.perform(bins.data(), time.data(), false);
+
+            auto* samples = samples_.data() + (size_t) (getOffset(level, frame) + kGuardSamplesBefore);
+            for (int i = 0; i < size_; ++i)
+                samples[i] = time[(size_t) i].real() / (float) size_;
+
+            samples[-1] = samples[size_ - 1];
+            samples[size_] = samples[0];
+            samples[size_ + 1] = samples[1];
+        }
+    }
+
+    const Waveform waveform_;
+    const juce::File source_;
+    const int size_;
+    const int order_;
+    const int num_levels_;
+    const int num_frames_;
+    std::vector<float> samples_;
+
+    // No leak detector: the cache is a function-local static, so cached tables
+    // outlive the detector's own counter at shutdown.
+    JUCE_DECLARE_NON_COPYABLE (SharedWavetable)
+};
+
+//==============================================================================
+/**
+Process-wide registry of SharedWavetables keyed by waveform (or source file,
+for user tables) and size.
+
+The first request for a table builds it; every later request gets the same
+object back, so all voices read one cache-resident copy. Call these from the
+message thread, a loader thread or a constructor, never from the audio
+thread: they take a lock and may allocate.
+
+The cache holds a reference to every table until purgeUnused(), so the audio
+thread can drop its own references without ever freeing one. Tables are kept
+in least-recently-used order, so a purge keeps the banks picked last.
+*/
+class WavetableCache
+{
+public:
+    static WavetableCache& getInstance()
+    {
+        static WavetableCache instance;
+        return instance;
+    }
+
+    SharedWavetable::Ptr get(Waveform waveform, int size)
+    {
+        const juce::ScopedLock sl(lock_);
+
+        for (auto it = tables_.begin(); it != tables_.end(); ++it)
+        {
+            if ((*it)->getSource() == juce::File() && (*it)->getWaveform() == waveform
+                  && (*it)->getSize() == size)
+                return touch(it);
+        }
+
+        tables_.emplace_back(new SharedWavetable(waveform, size));
+        return tables_.back();
+    }
+
+    /** The user table already built from file at this size, or nullptr. */
+    SharedWavetable::Ptr find(const juce::File& file, int size)
+    {
+        const juce::ScopedLock sl(lock_);
+
+        for (auto it = tables_.begin(); it != tables_.end(); ++it)
+        {
+            if ((*it)->getSource() == file && (*it)->getSize() == size)
+                return touch(it);
+        }
+
+        return nullptr;
+    }
+
+    /**
+    Registers a freshly built user table. If another thread got there first
+    with the same file, that table is returned instead and this one dropped.
+    */
+    SharedWavetable::Ptr add(SharedWavetable::Ptr table)
+    {
+        jassert(table != nullptr && table->getSource() != juce::File());
+
+        const juce::ScopedLock sl(lock_);
+
+        for (auto it = tables_.begin(); it != tables_.end(); ++it)
+        {
+            if ((*it)->getSource() == table->getSource() && (*it)->getSize() == table->getSize())
+                return touch(it);
+        }
+
+        tables_.push_back(table);
+        return table;
+    }
+
+    /**
+    Drops tables that nothing but the cache holds any more, apart from the
+    keepUnused most recently used of them, which stay for a quick switch back.
+    */
+    void purgeUnused(int keepUnused = 0)
+    {
+        const juce::ScopedLock sl(lock_);
+
+        int unused = 0;
+
+        // Newest first, so the tables kept are the recent ones
+        for (auto it = tables_.end(); it != tables_.begin();)
+        {
+            --it;
+
+            if ((*it)->getReferenceCount() == 1 && ++unused > keepUnused)
+                it = tables_.erase(it);
+        }
+    }
+
+private:
+    WavetableCache() = default;
+
+    /** Moves a table to the most recently used end and returns it. */
+    SharedWavetable::Ptr touch(std::vector<SharedWavetable::Ptr>::iterator it)
+    {
+        std::rotate(it, it + 1, tables_.end());
+        return tables_.back();
+    }
+
+    juce::CriticalSection lock_;
+    std::vector<SharedWavetable::Ptr> tables_;
+
+    JUCE_DECLARE_NON_COPYABLE (WavetableCache)
+};
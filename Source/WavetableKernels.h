@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    WavetableKernels.h
+    Created: 17 Oct 2026 11:04:51am
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Interpolation.h"
+
+#include <algorithm>
+
+//==============================================================================
+/**
+Block oscillator kernels: render N samples of table lookup + linear
+interpolation in one go.
+
+Every kernel has the same signature. It adds
+    amplitude * gains[i] * table(phase)
+into output for numSamples samples and leaves phase pointing at the next
+sample; gains is a block of per-sample envelope values, so the envelope is
+applied in the same pass as the table lookup. The table
+must hold 2^tableOrder samples with SharedWavetable's guard samples around
+them.
+
+Phase is unsigned 32-bit fixed point with the whole range being one cycle:
+the top tableOrder bits are the table index and the bits below them the
+interpolation fraction. The wrap is the add overflowing, so it costs
+nothing and never drifts.
+
+Use getRenderFunction() to get the fastest kernel the CPU supports for an
+interpolation tier. Linear has hand-written SSE2 and AVX2 kernels; the other
+tiers run renderInterpolated().
+
+The vector kernels render a block's last few samples through the same
+vector code, on padded copies, rather than a scalar tail. Every sample
+therefore goes through the same arithmetic wherever a block happens to end,
+so splitting a render differently never changes the output.
+*/
+namespace WavetableKernels
+{
+    using RenderFunction = void (*)(const float* table, int tableOrder,
+                                    juce::uint32& phase, juce::uint32 delta,
+                                    float amplitude, const float* gains,
+                                    float* output, int numSamples);
+
+    //==========================================================================
+    inline void renderScalar(const float* table, int tableOrder,
+                             juce::uint32& phase, juce::uint32 delta,
+                             float amplitude, const float* gains,
+                             float* output, int numSamples) noexcept
+    {
+        const int shift = 32 - tableOrder;
+        const auto frac_mask = (juce::uint32) ((1u << shift) - 1);
+        const auto frac_scale = 1.0f / (float) (1u << shift);
+        auto current = phase;
+
+        for (int idx = 0; idx < numSamples; ++idx)
+        {
+            auto index0 = current >> shift;
+            auto frac = (float) (current & frac_mask) * frac_scale;
+            auto value0 = table[index0];
+            auto value1 = table[index0 + 1];
+
+            output[idx] += amplitude * gains[idx] * (value0 + frac * (value1 - value0));
+            current += delta;
+        }
+
+        phase = current;
+    }
+
+    /** Any interpolation tier, one sample at a time. */
+    template <Interpolation Quality>
+    inline void renderInterpolated(const float* table, int tableOrder,
+                                   juce::uint32& phase, juce::uint32 delta,
+                                   float amplitude, const float* gains,
+                                   float* output, int numSamples) noexcept
+    {
+        const int shift = 32 - tableOrder;
+        const auto frac_mask = (juce::uint32) ((1u << shift) - 1);
+        const auto frac_scale = 1.0f / (float) (1u << shift);
+        auto current = phase;
+
+        for (int idx = 0; idx < numSamples; ++idx)
+        {
+            auto frac = (float) (current & frac_mask) * frac_scale;
+            auto sample = Interpolator<Quality>::template read<LanesScalar>(table, (juce::int32) (current >> shift), frac);
+
+            output[idx] += amplitude * gains[idx] * sample;
+            current += delta;
+        }
+
+        phase = current;
+    }
+
+   #if JUCE_INTEL
+    //==========================================================================
+    /** Four samples per iteration. SSE2 has no gather, so the table reads are scalar. */
+    inline void renderSSE2(const float* table, int tableOrder,
+                           juce::uint32& phase, juce::uint32 delta,
+                           float amplitude, const float* gains,
+                           float* output, int numSamples) noexcept
+    {
+        const auto shift = _mm_cvtsi32_si128(32 - tableOrder);
+        const auto frac_mask = _mm_set1_epi32((int) ((1u << (32 - tableOrder)) - 1));
+        const auto frac_scale = _mm_set1_ps(1.0f / (float) (1u << (32 - tableOrder)));
+        const auto step = _mm_set1_epi32((int) (4 * delta));
+        const auto vamplitude = _mm_set1_ps(amplitude);
+
+        auto lanes = _mm_setr_epi32((int) phase,             (int) (phase + delta),
+                                    (int) (phase + 2 * delta), (int) (phase + 3 * delta));
+
+        alignas(16) int index[4];
+        alignas(16) float tail_gains[4], tail_output[4];
+
+        for (int idx = 0; idx < numSamples; idx += 4)
+        {
+            const int num = juce::jmin(4, numSamples - idx);
+            const float* block_gains = gains + idx;
+            float* block_output = output + idx;
+
+            if (num < 4)
+            {
+                std::fill_n(tail_gains, 4, 0.0f);
+                std::fill_n(tail_output, 4, 0.0f);
+                std::copy_n(block_gains, num, tail_gains);
+                std::copy_n(block_output, num, tail_output);
+                block_gains = tail_gains;
+                block_output = tail_output;
+            }
+
+            auto frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(lanes, frac_mask)), frac_scale);
+            _mm_store_si128((__m128i*) index, _mm_srl_epi32(lanes, shift));
+
+            auto value0 = _mm_setr_ps(table[index[0]],     table[index[1]],
+                                      table[index[2]],     table[index[3]]);
+            auto value1 = _mm_setr_ps(table[index[0] + 1], table[index[1] + 1],
+                                      table[index[2] + 1], table[index[3] + 1]);
+
+            auto sample = _mm_add_ps(value0, _mm_mul_ps(frac, _mm_sub_ps(value1, value0)));
+            auto gain = _mm_mul_ps(_mm_loadu_ps(block_gains), vamplitude);
+            _mm_storeu_ps(block_output,
+                          _mm_add_ps(_mm_loadu_ps(block_output), _mm_mul_ps(sample, gain)));
+
+            if (num < 4)
+                std::copy_n(tail_output, num, output + idx);
+
+            lanes = _mm_add_epi32(lanes, step);
+        }
+
+        phase += (juce::uint32) numSamples * delta; // wraps like the lanes do
+    }
+
+    //==========================================================================
+    /** Eight samples per iteration, using hardware gathers for the table reads. */
+    SIMD_TARGET_AVX2
+    inline void renderAVX2(const float* table, int tableOrder,
+                           juce::uint32& phase, juce::uint32 delta,
+                           float amplitude, const float* gains,
+                           float* output, int numSamples) noexcept
+    {
+        const auto shift = _mm_cvtsi32_si128(32 - tableOrder);
+        const auto frac_mask = _mm256_set1_epi32((int) ((1u << (32 - tableOrder)) - 1));
+        const auto frac_scale = _mm256_set1_ps(1.0f / (float) (1u << (32 - tableOrder)));
+        const auto step = _mm256_set1_epi32((int) (8 * delta));
+        const auto vamplitude = _mm256_set1_ps(amplitude);
+        const auto one = _mm256_set1_epi32(1);
+
+        auto lanes = _mm256_add_epi32(_mm256_set1_epi32((int) phase),
+                                      _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                         _mm256_set1_epi32((int) delta)));
+
+        alignas(32) float tail_gains[8], tail_output[8];
+
+        for (int idx = 0; idx < numSamples; idx += 8)
+        {
+            const int num = juce::jmin(8, numSamples - idx);
+            const float* block_gains = gains + idx;
+            float* block_output = output + idx;
+
+            if (num < 8)
+            {
+                std::fill_n(tail_gains, 8, 0.0f);
+                std::fill_n(tail_output, 8, 0.0f);
+                std::copy_n(block_gains, num, tail_gains);
+                std::copy_n(block_output, num, tail_output);
+                block_gains = tail_gains;
+                block_output = tail_output;
+            }
+
+            auto index0 = _mm256_srl_epi32(lanes, shift);
+            auto frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(lanes, frac_mask)), frac_scale);
+
+            auto value0 = _mm256_i32gather_ps(table, index0, 4);
+            auto value1 = _mm256_i32gather_ps(table, _mm256_add_epi32(index0, one), 4);
+
+            auto sample = _mm256_fmadd_ps(frac, _mm256_sub_ps(value1, value0), value0);
+            auto gain = _mm256_mul_ps(_mm256_loadu_ps(block_gains), vamplitude);
+            _mm256_storeu_ps(block_output,
+                             _mm256_fmadd_ps(sample, gain, _mm256_loadu_ps(block_output)));
+
+            if (num < 8)
+                std::copy_n(tail_output, num, output + idx);
+
+            lanes = _mm256_add_epi32(lanes, step);
+        }
+
+        phase += (juce::uint32) numSamples * delta; // wraps like the lanes do
+    }
+   #endif
+
+    //==========================================================================
+    inline RenderFunction chooseRenderFunction() noexcept
+    {
+       #if JUCE_INTEL
+        if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+            return renderAVX2;
+
+        if (juce::SystemStats::hasSSE2())
+            return renderSSE2;
+       #endif
+
+        return renderScalar;
+    }
+
+    /** The CPU is probed once; after that this is just a load. */
+    inline RenderFunction getRenderFunction(Interpolation quality = Interpolation::linear) noexcept
+    {
+        static const RenderFunction render = chooseRenderFunction();
+
+        switch (quality)
+        {
+            case Interpolation::truncate: return renderInterpolated<Interpolation::truncate>;
+            case Interpolation::hermite:  return renderInterpolated<Interpolation::hermite>;
+            case Interpolation::lagrange: return renderInterpolated<Interpolation::lagrange>;
+            default:                      return render;
+        }
+    }
+}
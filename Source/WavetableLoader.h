@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    WavetableLoader.h
+    Created: 17 Oct 2026 10:48:31pm
+    Author:  SIGMusic
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableCache.h"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+
+//==============================================================================
+/**
+Builds user wavetables from WAV files, on a background thread or inline.
+
+A file holds either one single-cycle frame or a bank of equal-length frames
+back to back. It is only read as a bank when the caller gives a frame size
+or the file states one: Serum and the editors that follow it write a
+"clm " chunk with the samples per frame. Anything else is a single cycle,
+however long, so a 4096-sample cycle is never chopped into two. It is opened through
+a memory-mapped reader, so opening costs a few page mappings however big the
+bank is. Each frame is decoded from the mapping only when its mip levels are
+being built, so at most one decoded frame is held at once besides the table.
+
+The table itself is built in full before it is handed over, every frame at
+every level: the audio thread can't build anything, so there is no lazy
+decoding past this point. That costs memory (about 50 MB for a full bank of
+kMaxFrames frames, see SharedWavetable) and load time, which the loader
+thread absorbs. Banks longer than kMaxFrames frames are cut to their first
+kMaxFrames, and the caller is told.
+
+Finished tables go into WavetableCache, so loading the same file again (a
+patch switch back, say) is a lookup. Only the first channel is read.
+*/
+class WavetableLoader
+{
+public:
+    static constexpr int kFrameSizeFromFile = 0; // use the file's "clm " chunk, or read one cycle
+    static constexpr int kMaxFrames = 256;
+    static constexpr int kMaxCycleLength = 1 << 16;
+
+    /**
+    Called on the loader thread with the table, or nullptr and a reason. A
+    table can come with a non-empty error too, saying what was left out.
+    */
+    using Callback = std::function<void(SharedWavetable::Ptr table, const juce::String& error)>;
+
+    WavetableLoader() = default;
+
+    ~WavetableLoader()
+    {
+        stop();
+    }
+
+    /**
+    Builds the table for file, or returns the cached one, on the calling
+    thread. Never call this from the audio thread. On failure returns
+    nullptr and describes the problem in error. A bank of more than
+    kMaxFrames frames loads its first kMaxFrames and says so in error.
+    */
+    static SharedWavetable::Ptr load(const juce::File& file, int tableSize, juce::String& error,
+                                     int frameSize = kFrameSizeFromFile)
+    {
+        auto& cache = WavetableCache::getInstance();
+
+        if (auto cached = cache.find(file, tableSize); cached != nullptr)
+            return cached;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(wav.createMemoryMappedReader(file));
+
+        if (reader == nullptr || ! reader->mapEntireFile())
+        {
+            error = "Couldn't map " + file.getFullPathName() + " as a WAV file";
+            return nullptr;
+        }
+
+        const auto length = reader->lengthInSamples;
+        const int frame_size = frameSize > 0 ? frameSize : readFrameSize(file);
+
+        // Without a frame size, or with one that doesn't fit, it is a single cycle
+        const auto frame_length = frame_size > 0 && length >= frame_size && length % frame_size == 0
+                                    ? (juce::int64) frame_size
+                                    : length;
+        if (frame_length <= 1 || frame_length > kMaxCycleLength)
+        {
+            error = file.getFullPathName() + " doesn't look like a wavetable";
+            return nullptr;
+        }
+
+        const auto file_frames = length / frame_length;
+        const int num_frames = (int) juce::jmin((juce::int64) kMaxFrames, file_frames);
+
+        if (file_frames > num_frames)
+            error = file.getFileName() + " has " + juce::String(file_frames) + " frames; only the first "
+                  + juce::String(num_frames) + " are used";
+
+        SharedWavetable::Ptr table(new SharedWavetable(file, tableSize, num_frames,
+                                                       [&](int frame, std::vector<float>& cycle)
+        {
+            cycle.assign((size_t) frame_length, 0.0f);
+            float* const channels[] = { cycle.data() };
+            reader->read(channels, 1, (juce::int64) frame * frame_length, (int) frame_length);
+        }));
+
+        return cache.add(table);
+    }
+
+    /**
+    Loads file on the loader thread and hands the table to callback there,
+    always; a table that is already cached just takes a lookup. Call this
+    from the message thread.
+    */
+    void loadAsync(const juce::File& file, int tableSize, Callback callback,
+                   int frameSize = kFrameSizeFromFile)
+    {
+        pool_.addJob([file, tableSize, frameSize, callback]
+        {
+            juce::String error;
+            auto table = load(file, tableSize, error, frameSize);
+            callback(table, error);
+        });
+    }
+
+    /** Drops loads that haven't started and waits for the current one. */
+    void stop()
+    {
+        pool_.removeAllJobs(true, kStopTimeoutMs);
+    }
+
+    /**
+    The samples per frame that a wavetable editor wrote into file, or 0 if
+    it wrote none. The "clm " chunk's text starts "<!>" and the frame size,
+    e.g. "<!>2048 01000000 wavetable (www.xferrecords.com)".
+    */
+    static int readFrameSize(const juce::File& file)
+    {
+        juce::FileInputStream stream(file);
+        char id[4];
+
+        if (! stream.openedOk()
+              || stream.read(id, 4) != 4 || std::memcmp(id, "RIFF", 4) != 0
+              || (stream.readInt(), stream.read(id, 4)) != 4 || std::memcmp(id, "WAVE", 4) != 0)
+            return 0;
+
+        while (stream.read(id, 4) == 4)
+        {
+            const auto size = (juce::uint32) stream.readInt();
+            const auto next = stream.getPosition() + (juce::int64) size + (size & 1); // chunks are word aligned
+
+            if (std::memcmp(id, "clm ", 4) == 0)
+            {
+                char text[kFrameSizeTextLength + 1] = {};
+                stream.read(text, (int) juce::jmin((juce::uint32) kFrameSizeTextLength, size));
+
+                const juce::String content(text);
+                return content.startsWith("<!>") ? juce::jmax(0, content.substring(3).getIntValue()) : 0;
+            }
+
+            if (! stream.setPosition(next))
+                break;
+        }
+
+        return 0;
+    }
+
+private:
+    static constexpr int kStopTimeoutMs = 10000;
+    static constexpr int kFrameSizeTextLength = 16; // "<!>" and the size, with room to spare
+
+    juce::ThreadPool pool_ { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableLoader)
+};
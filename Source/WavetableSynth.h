@@ -11,6 +11,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "WavetableKernels.h"
+#include "NoteFrequencyTable.h"
+#include "WavetableCache.h"
+#include "ADSREnvelope.h"
+#include "StereoPan.h"
 
 //==============================================================================
 /*
@@ -19,7 +24,9 @@ class WavetableSynth  : public juce::ToneGeneratorAudioSource
 {
 public:
     // TODO
-    WavetableSynth()
+    explicit WavetableSynth(Waveform waveform = Waveform::sine)
+        : waveform_(waveform),
+          render_block_(WavetableKernels::getRenderFunction())
     {
         buildWavetable();
     }
@@ -32,123 +39,291 @@ public:
         amplitude_ = amp;
     }
 
-    void setFrequency(float frequency)
+    /**
+    Sets the phase step from a multiply by the per-sample-rate scale that
+    prepareToPlay() caches, and picks the band-limited table level that step
+    can play without aliasing. The step is rounded once, so the pitch error
+    is below 1e-5 Hz and the phase never accumulates rounding error.
+    */
+    void setFrequency(float frequency) noexcept
     {
         frequency_ = frequency;
-        prepareToPlay(0, sample_rate_);
+        const auto step = (double) frequency * phase_per_hz_;
+        table_delta_ = (juce::uint32) (juce::int64) std::llround(step);
+        // Fewer harmonics the further we step through the table
+        table_level_ = wavetable_->getLevelForIncrement((float) step * table_steps_per_phase_);
+    }
+
+    //==========================================================================
+    // ADSR
+
+    void setAttack(float seconds) noexcept  { envelope_.setAttack(seconds); }
+    void setDecay(float seconds) noexcept   { envelope_.setDecay(seconds); }
+    void setSustain(float level) noexcept   { envelope_.setSustain(level); }
+    void setRelease(float seconds) noexcept { envelope_.setRelease(seconds); }
+
+    const ADSREnvelope& getEnvelope() const noexcept { return envelope_; }
+
+    //==========================================================================
+    // Quality
+
+    /**
+    Picks how this voice reads between table samples, trading cost for
+    accuracy: truncate for cheap background voices, hermite or lagrange for
+    mastering renders.
+    */
+    void setInterpolation(Interpolation quality) noexcept
+    {
+        interpolation_ = quality;
+        render_block_ = WavetableKernels::getRenderFunction(quality);
+    }
+
+    Interpolation getInterpolation() const noexcept { return interpolation_; }
+
+    /** Places this voice in the stereo field, from -1 (hard left) to 1 (hard right). */
+    void setPan(float pan) noexcept
+    {
+        pan_ = juce::jlimit(-1.0f, 1.0f, pan);
+        StereoPan::getGains(pan_, pan_left_, pan_right_);
+    }
+
+    float getPan() const noexcept { return pan_; }
+
+    /**
+    Where in a multi-frame table this voice plays, from 0 (the first frame)
+    to 1 (the last). Between two frames the voice crossfades between them;
+    the weight is fixed until the next call, so set it once per block.
+    */
+    void setPosition(float position) noexcept
+    {
+        position_ = juce::jlimit(0.0f, 1.0f, position);
+
+        const int last = wavetable_->getNumFrames() - 1;
+        const auto scaled = position_ * (float) last;
+
+        frame_ = juce::jmin((int) scaled, last);
+        frame_mix_ = frame_ < last ? scaled - (float) frame_ : 0.0f;
+    }
+
+    float getPosition() const noexcept { return position_; }
+
+    //==========================================================================
+    // Voice control
+
+    /**
+    Restarts the oscillator at the given frequency and starts the attack
+    stage. Never allocates.
+    */
+    void noteOn(float frequency, float velocity) noexcept
+    {
+        current_index_ = 0;
+        amplitude_ = velocity;
+        setFrequency(frequency);
+        envelope_.noteOn();
+    }
+
+    /** Starts the release stage; the voice stays active until it has rung out. */
+    void noteOff() noexcept
+    {
+        envelope_.noteOff();
+    }
+
+    bool isActive() const noexcept { return envelope_.isActive(); }
+
+    /**
+    Adds the next numSamples samples of this voice on top of whatever is
+    already in output.
+    */
+    void renderNextBlock(float* output, int numSamples) noexcept
+    {
+        if (! isActive())
+            return;
+
+        renderBlock(output, numSamples);
     }
 
     // TODO
 
     /**
-    Calculates the number of "steps" to take through the table per sample.
-    TODO
+    Caches the phase step per hertz for this sample rate, then recomputes
+    the step for the current frequency.
     */
     virtual void prepareToPlay(
         int /* parameter not needed */, double sampleRate) override
     {
+        if (sampleRate != sample_rate_)
+            envelope_.setSampleRate(sampleRate);
+
         sample_rate_ = sampleRate;
-        // Ratio of samples per table run to samples per second
-        float tableSizeOverSampleRate = (float) table_size_ / sample_rate_;
-        // Calculate number of steps to take through the table per sample
-        table_delta_ = frequency_ * tableSizeOverSampleRate;
+        phase_per_hz_ = NoteFrequencyTable::kPhaseScale / sampleRate;
+        setFrequency(frequency_);
     }
 
     /**
     This fills the audio buffer with the samples that the synth generates.
+    The voice is rendered a chunk at a time into a mono scratch buffer, which
+    is then written once into every channel from startSample on, scaled by
+    that channel's pan gain. A finished voice just clears the region, and
+    denormals are flushed to zero while rendering.
     */
     virtual void getNextAudioBlock(
         const juce::AudioSourceChannelInfo &bufferToFill) override
     {
-        bufferToFill.clearActiveBufferRegion();
-        auto* buf0 = bufferToFill.buffer->getWritePointer(0);
+        if (! isActive())
+        {
+            bufferToFill.clearActiveBufferRegion();
+            return;
+        }
 
-        for (unsigned int idx = 0; idx < bufferToFill.numSamples; ++idx)
+        const juce::ScopedNoDenormals no_denormals;
+        auto& buffer = *bufferToFill.buffer;
+
+        for (int start = 0; start < bufferToFill.numSamples; start += kGainChunkSize)
         {
-            // TODO
-            buf0[idx] = amplitude_ * getNextSample();
+            const int num = juce::jmin(kGainChunkSize, bufferToFill.numSamples - start);
+
+            juce::FloatVectorOperations::clear(mix_, num);
+            renderBlock(mix_, num);
+
+            for (int chan_idx = 0; chan_idx < buffer.getNumChannels(); ++chan_idx)
+            {
+                const auto gain = buffer.getNumChannels() == 1 ? StereoPan::kMonoGain * (pan_left_ + pan_right_)
+                                : StereoPan::isLeftChannel(chan_idx) ? pan_left_ : pan_right_;
+                juce::FloatVectorOperations::copyWithMultiply(
+                    buffer.getWritePointer(chan_idx, bufferToFill.startSample + start), mix_, gain, num);
+            }
         }
+    }
 
-        // Duplicate signal across all channels
-        for (unsigned int chan_idx = 1;
-             chan_idx < bufferToFill.buffer->getNumChannels();
-             ++chan_idx)
+    /**
+    Adds amplitude_ * envelope * the next numSamples samples into output.
+    The envelope is rendered a chunk at a time into gains_ and then applied
+    inside the fastest block kernel for this CPU and interpolation tier.
+    Between two frames the kernel runs once per frame from the same phase,
+    each pass scaled by that frame's crossfade weight.
+    */
+    void renderBlock(float* output, int numSamples) noexcept
+    {
+        jassert(table_size_ > 0);
+
+        for (int start = 0; start < numSamples; start += kGainChunkSize)
         {
-            auto* buf = bufferToFill.buffer->getWritePointer(chan_idx);
-            for (unsigned int idx = 0; idx < bufferToFill.numSamples; ++idx)
+            const int num = juce::jmin(kGainChunkSize, numSamples - start);
+            envelope_.render(gains_, num);
+
+            if (frame_mix_ == 0.0f)
             {
-                buf[idx] = buf0[idx];
+                render_block_(wavetable_->getReadPointer(table_level_, frame_), table_order_,
+                              current_index_, table_delta_, amplitude_, gains_,
+                              output + start, num);
+                continue;
             }
+
+            auto phase = current_index_;
+            render_block_(wavetable_->getReadPointer(table_level_, frame_), table_order_,
+                          phase, table_delta_, amplitude_ * (1.0f - frame_mix_), gains_,
+                          output + start, num);
+            render_block_(wavetable_->getReadPointer(table_level_, frame_ + 1), table_order_,
+                          current_index_, table_delta_, amplitude_ * frame_mix_, gains_,
+                          output + start, num);
         }
     }
 
     /**
-    Get the next sample in the wavetable based on the current index and the step size.
+    Get the next sample in the wavetable based on the current index and the step size,
+    read with this voice's interpolation tier.
      TODO
     */
     forcedinline float getNextSample() noexcept
     {
-        jassert(table_size_ > 0);
+        switch (interpolation_)
+        {
+            case Interpolation::truncate: return getNextSample<Interpolation::truncate>();
+            case Interpolation::hermite:  return getNextSample<Interpolation::hermite>();
+            case Interpolation::lagrange: return getNextSample<Interpolation::lagrange>();
+            default:                      return getNextSample<Interpolation::linear>();
+        }
+    }
 
-        auto index0 = (unsigned int) current_index_;
-        auto index1 = index0 + 1;
+    /** The same, with the tier fixed at compile time so a caller's loop has no dispatch at all. */
+    template <Interpolation Quality>
+    forcedinline float getNextSample() noexcept
+    {
+        jassert(table_size_ > 0);
 
-        auto frac = current_index_ - (float) index0;
+        const int shift = 32 - table_order_;
+        auto index = (juce::int32) (current_index_ >> shift);
+        auto frac = (float) (current_index_ & ((1u << shift) - 1)) * (1.0f / (float) (1u << shift));
 
-        auto* table = wavetable_.getReadPointer (0);
-        auto value0 = table[index0];
-        auto value1 = table[index1];
+        auto* table = wavetable_->getReadPointer(table_level_, frame_);
+        auto currentSample = Interpolator<Quality>::template read<LanesScalar>(table, index, frac);
 
-        auto currentSample = value0 + frac * (value1 - value0); // interpolate
+        if (frame_mix_ != 0.0f)
+        {
+            const auto next = Interpolator<Quality>::template read<LanesScalar>(
+                table + wavetable_->getFrameStride(), index, frac);
+            currentSample += frame_mix_ * (next - currentSample);
+        }
 
-        if ((current_index_ += table_delta_) > (float) table_size_)
-          current_index_ -= (float) table_size_; // Wrap around the table
+        current_index_ += table_delta_; // Wraps around the table by overflowing
 
         return currentSample;
     }
     
     /**
-        Build the wavetable here using the table size.
-        TODO
+        Fetch the shared wavetable for this waveform and size. The table itself
+        is built once per process by WavetableCache; every voice reads the same
+        copy, so this costs a lookup rather than table_size_ calls to std::sin.
     */
     void buildWavetable()
     {
-        wavetable_.setSize(1, table_size_ + 1);
-        auto* samples = wavetable_.getWritePointer(0);
- 
-        // Fill with one period of sine
-        auto angleDelta = juce::MathConstants<double>::twoPi / (double) (table_size_ - 1);
-        auto currentAngle = 0.0;
- 
-        for (unsigned int i = 0; i < table_size_; ++i)
-        {
-            auto sample = std::sin(currentAngle);
-            samples[i] = (float) sample;
-            currentAngle += angleDelta;
-        }
-
-        samples[table_size_] = samples[0];
+        setWavetable(WavetableCache::getInstance().get(waveform_, table_size_));
     }
 
-private:
-
-    float calcAmplitude()
+    /**
+    Plays another table, such as a user table from WavetableLoader, keeping
+    the current phase. Call it from the thread that renders this voice.
+    */
+    void setWavetable(SharedWavetable::Ptr table)
     {
-        // TODO
+        jassert(table != nullptr);
+        wavetable_ = std::move(table);
+        table_size_ = wavetable_->getSize();
+        table_order_ = wavetable_->getOrder();
+        table_steps_per_phase_ = (float) (table_size_ / NoteFrequencyTable::kPhaseScale);
+        setFrequency(frequency_);
+        setPosition(position_);
     }
 
+private:
+
     // Begin wavetable data
-    juce::AudioSampleBuffer wavetable_;
+    SharedWavetable::Ptr wavetable_;
+    Waveform waveform_;
     int table_size_ = 4096;
+    int table_order_ = 12;
+    float table_steps_per_phase_ = 0.0f;
+    int table_level_ = 0;
+    float position_ = 0.0f;
+    int frame_ = 0;
+    float frame_mix_ = 0.0f;
     double sample_rate_ = 48000.0;
+    double phase_per_hz_ = NoteFrequencyTable::kPhaseScale / 48000.0;
     // TODO
     float amplitude_ = 0.0f;
     float frequency_ = 440.0f;
-    float current_index_ = 0.0f, table_delta_ = 0.0f;
+    // Fixed-point phase: the full 32-bit range is one trip through the table
+    juce::uint32 current_index_ = 0, table_delta_ = 0;
+    Interpolation interpolation_ = Interpolation::linear;
+    WavetableKernels::RenderFunction render_block_;
+    float pan_ = 0.0f, pan_left_ = 1.0f, pan_right_ = 1.0f;
     // End wavetable data
 
     // Begin ADSR data
-    // TODO
+    static constexpr int kGainChunkSize = 256;
+    ADSREnvelope envelope_;
+    float gains_[kGainChunkSize];
+    float mix_[kGainChunkSize];
     // End ADSR data
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableSynth)